@@ -76,13 +76,36 @@ typedef enum alloc_handle_flag : alloc_t
 	ALLOC_HANDLE_FLAG_NONE					= 0,
 	ALLOC_HANDLE_FLAG_IMMEDIATE_FREE		= 1 << 0,
 	ALLOC_HANDLE_FLAG_DO_NOT_FREE			= 1 << 1,
+	ALLOC_HANDLE_FLAG_LAZY_FREE				= 1 << 2,
 }
 alloc_handle_flag_t;
 
 
+typedef enum alloc_page_flag : alloc_t
+{
+	ALLOC_PAGE_FLAG_NONE					= 0,
+	ALLOC_PAGE_FLAG_HUGE					= 1 << 0,
+	ALLOC_PAGE_FLAG_POPULATE				= 1 << 1,
+	ALLOC_PAGE_FLAG_NODE					= 1 << 2,
+}
+alloc_page_flag_t;
+
+
+#define ALLOC_PAGE_FLAG_NODE_SHIFT 16
+#define ALLOC_PAGE_FLAG_NODE_MASK	\
+	(ALLOC_PAGE_FLAG_NODE | ((alloc_t) UINT8_MAX << ALLOC_PAGE_FLAG_NODE_SHIFT))
+
+#define ALLOC_PAGE_FLAG_BIND_NODE(node)			\
+	((alloc_page_flag_t)(ALLOC_PAGE_FLAG_NODE |	\
+		((alloc_t)(node) << ALLOC_PAGE_FLAG_NODE_SHIFT)))
+
+#define ALLOC_PAGE_FLAG_GET_NODE(flags)	\
+	(((alloc_t)(flags) >> ALLOC_PAGE_FLAG_NODE_SHIFT) & UINT8_MAX)
+
+
 typedef struct alloc_handle
 {
-	alloc_t _[10 + MACRO_ALIGN_UP_CONST(sizeof(sync_mtx_t),
+	alloc_t _[26 + MACRO_ALIGN_UP_CONST(sizeof(sync_mtx_t),
 		sizeof(alloc_t) - 1) / sizeof(alloc_t)];
 }
 alloc_handle_t;
@@ -93,6 +116,8 @@ typedef struct alloc_handle_info
 	alloc_t alloc_size;
 	alloc_t block_size;
 	alloc_t alignment;
+	alloc_handle_flag_t flags;
+	alloc_page_flag_t page_flags;
 }
 alloc_handle_info_t;
 
@@ -108,13 +133,22 @@ typedef struct alloc_state_info
 	alloc_handle_info_t* handles;
 	alloc_t handle_count;
 	alloc_idx_fn_t idx_fn;
+	alloc_handle_flag_t flags;
+	alloc_page_flag_t page_flags;
+	uint32_t class_steps;
 }
 alloc_state_info_t;
 
 
+#define ALLOC_CLASS_STEPS_MAX 4
+#define ALLOC_IDX_TABLE_SIZE 512
+
+
 typedef struct alloc_state
 {
 	alloc_idx_fn_t idx_fn;
+	uint32_t class_shift;
+	uint8_t idx_table[ALLOC_IDX_TABLE_SIZE];
 
 	alloc_t handle_count;
 	alloc_handle_t handles[];
@@ -128,6 +162,55 @@ alloc_get_global_state(
 	);
 
 
+typedef struct alloc_node_usage
+{
+	alloc_t objects;
+	alloc_t blocks;
+	alloc_t bytes_in_use;
+	alloc_t bytes_committed;
+}
+alloc_node_usage_t;
+
+
+extern void
+alloc_set_node_topology(
+	alloc_t node_count,
+	_in_ uint8_t* cpu_nodes,
+	alloc_t cpu_count
+	);
+
+
+extern alloc_t
+alloc_get_node_count(
+	void
+	);
+
+
+extern alloc_t
+alloc_get_current_node(
+	void
+	);
+
+
+extern const alloc_state*
+alloc_get_node_state(
+	alloc_t node
+	);
+
+
+extern const alloc_state*
+alloc_get_local_state(
+	void
+	);
+
+
+extern void
+alloc_get_node_usage(
+	alloc_t node,
+	_out_ alloc_node_usage_t* usage
+	);
+
+
 extern _const_func_ alloc_t
 alloc_get_page_size(
 	void
@@ -169,6 +252,39 @@ alloc_free_virtual_aligned(
 	);
 
 
+extern _alloc_func_ void*
+alloc_alloc_virtual_flags(
+	alloc_t size,
+	alloc_page_flag_t flags
+	);
+
+
+extern void
+alloc_free_virtual_flags(
+	_opaque_ void* ptr,
+	alloc_t size,
+	alloc_page_flag_t flags
+	);
+
+
+extern _alloc_func_ void*
+alloc_alloc_virtual_aligned_flags(
+	alloc_t size,
+	alloc_t alignment,
+	alloc_page_flag_t flags,
+	_out_ void** ptr
+	);
+
+
+extern void
+alloc_free_virtual_aligned_flags(
+	_opaque_ void* real_ptr,
+	alloc_t size,
+	alloc_t alignment,
+	alloc_page_flag_t flags
+	);
+
+
 extern _alloc_func_ void*
 alloc_realloc_virtual(
 	_opaque_ void* ptr,
@@ -298,6 +414,108 @@ alloc_handle_get_flags_uh(
 	);
 
 
+typedef struct alloc_handle_stats
+{
+	alloc_t alloc_size;
+	alloc_t block_size;
+
+	alloc_t objects;
+	alloc_t peak_objects;
+
+	alloc_t blocks;
+	alloc_t peak_blocks;
+	alloc_t retained_blocks;
+
+	alloc_t bytes_in_use;
+	alloc_t bytes_committed;
+	alloc_t peak_bytes_committed;
+
+	alloc_t locks;
+	alloc_t contended_locks;
+}
+alloc_handle_stats_t;
+
+
+extern void
+alloc_get_stats_h(
+	_opaque_ alloc_handle_t* handle,
+	_out_ alloc_handle_stats_t* stats
+	);
+
+
+extern void
+alloc_get_stats_uh(
+	_opaque_ alloc_handle_t* handle,
+	_out_ alloc_handle_stats_t* stats
+	);
+
+
+extern void
+alloc_get_stats_s(
+	_opaque_ alloc_state* state,
+	_out_ alloc_handle_stats_t* stats
+	);
+
+
+extern bool
+alloc_dump_stats_s(
+	_opaque_ alloc_state* state,
+	const char* path
+	);
+
+
+#define ALLOC_TRACE_MAGIC 0x43525441
+#define ALLOC_TRACE_VERSION 1
+
+
+typedef enum alloc_trace_op : uint32_t
+{
+	ALLOC_TRACE_OP_ALLOC,
+	ALLOC_TRACE_OP_CALLOC,
+	ALLOC_TRACE_OP_FREE,
+	ALLOC_TRACE_OP_REALLOC,
+	ALLOC_TRACE_OP_REALLOC_FAIL,
+}
+alloc_trace_op_t;
+
+
+typedef struct alloc_trace_header
+{
+	uint32_t magic;
+	uint32_t version;
+}
+alloc_trace_header_t;
+
+
+typedef struct alloc_trace_record
+{
+	uint64_t time;
+	uint64_t ptr;
+	uint64_t size;
+	uint32_t thread;
+	alloc_trace_op_t op;
+}
+alloc_trace_record_t;
+
+
+extern void
+alloc_purge_h(
+	_opaque_ alloc_handle_t* handle
+	);
+
+
+extern void
+alloc_purge_uh(
+	_opaque_ alloc_handle_t* handle
+	);
+
+
+extern void
+alloc_purge_s(
+	_opaque_ alloc_state* state
+	);
+
+
 extern _alloc_func_ void*
 alloc_alloc_h(
 	_opaque_ alloc_handle_t* handle,
@@ -330,6 +548,44 @@ alloc_free_uh(
 	);
 
 
+extern _warn_unused_result_ bool
+alloc_alloc_batch_h(
+	_opaque_ alloc_handle_t* handle,
+	_out_ void** ptrs,
+	alloc_t count,
+	alloc_t size,
+	int zero
+	);
+
+
+extern _warn_unused_result_ bool
+alloc_alloc_batch_uh(
+	_opaque_ alloc_handle_t* handle,
+	_out_ void** ptrs,
+	alloc_t count,
+	alloc_t size,
+	int zero
+	);
+
+
+extern void
+alloc_free_batch_h(
+	_opaque_ alloc_handle_t* handle,
+	void* const* ptrs,
+	alloc_t count,
+	alloc_t size
+	);
+
+
+extern void
+alloc_free_batch_uh(
+	_opaque_ alloc_handle_t* handle,
+	void* const* ptrs,
+	alloc_t count,
+	alloc_t size
+	);
+
+
 extern void*
 allow_realloc_h(
 	_opaque_ alloc_handle_t* old_handle,
@@ -350,3 +606,247 @@ allow_realloc_uh(
 	alloc_t new_size,
 	int zero
 	);
+
+
+extern void
+alloc_flush_thread_cache(
+	void
+	);
+
+
+typedef struct alloc_arena_chunk alloc_arena_chunk_t;
+
+
+typedef struct alloc_arena
+{
+	alloc_arena_chunk_t* head;
+	alloc_arena_chunk_t* chunk;
+	uint8_t* ptr;
+	uint8_t* end;
+	alloc_t chunk_size;
+	alloc_page_flag_t page_flags;
+}
+alloc_arena_t;
+
+
+typedef struct alloc_arena_mark
+{
+	alloc_arena_chunk_t* chunk;
+	uint8_t* ptr;
+}
+alloc_arena_mark_t;
+
+
+extern void
+alloc_arena_init(
+	_out_ alloc_arena_t* arena,
+	alloc_t chunk_size,
+	alloc_page_flag_t page_flags
+	);
+
+
+extern void
+alloc_arena_free(
+	_inout_ alloc_arena_t* arena
+	);
+
+
+extern _alloc_func_ void*
+alloc_arena_alloc(
+	_inout_ alloc_arena_t* arena,
+	alloc_t size,
+	alloc_t alignment,
+	int zero
+	);
+
+
+extern void
+alloc_arena_reset(
+	_inout_ alloc_arena_t* arena
+	);
+
+
+extern alloc_arena_mark_t
+alloc_arena_get_mark(
+	_in_ alloc_arena_t* arena
+	);
+
+
+extern void
+alloc_arena_rewind(
+	_inout_ alloc_arena_t* arena,
+	alloc_arena_mark_t mark
+	);
+
+
+extern alloc_arena_t*
+alloc_get_thread_arena(
+	void
+	);
+
+
+extern void
+alloc_free_thread_arena(
+	void
+	);
+
+
+typedef enum alloc_pool_flag : alloc_t
+{
+	ALLOC_POOL_FLAG_NONE					= 0,
+	ALLOC_POOL_FLAG_THREAD_CACHE			= 1 << 0,
+}
+alloc_pool_flag_t;
+
+
+typedef struct alloc_pool_slab alloc_pool_slab_t;
+
+
+typedef struct alloc_pool
+{
+	sync_mtx_t mtx;
+	void* free;
+	alloc_pool_slab_t* slabs;
+	uint8_t* ptr;
+	uint8_t* end;
+	alloc_t size;
+	alloc_t slab_size;
+	_Atomic alloc_t generation;
+	alloc_pool_flag_t flags;
+	_Atomic uint32_t cache_id;
+}
+alloc_pool_t;
+
+
+#define ALLOC_POOL_INIT(type, pool_flags)	\
+{											\
+	.mtx = SYNC_MTX_INIT,					\
+	.size = sizeof(type),					\
+	.flags = pool_flags						\
+}
+
+
+extern void
+alloc_pool_init(
+	_out_ alloc_pool_t* pool,
+	alloc_t size,
+	alloc_t slab_size,
+	alloc_pool_flag_t flags
+	);
+
+
+extern void
+alloc_pool_free(
+	_inout_ alloc_pool_t* pool
+	);
+
+
+extern void
+alloc_pool_reset(
+	_inout_ alloc_pool_t* pool
+	);
+
+
+extern _alloc_func_ void*
+alloc_pool_alloc(
+	_inout_ alloc_pool_t* pool,
+	int zero
+	);
+
+
+extern void
+alloc_pool_release(
+	_inout_ alloc_pool_t* pool,
+	_opaque_ void* ptr
+	);
+
+
+extern void
+alloc_flush_thread_pools(
+	void
+	);
+
+
+typedef struct alloc_region_large alloc_region_large_t;
+
+
+typedef struct alloc_region
+{
+	const alloc_state* state;
+	alloc_region_large_t* large;
+}
+alloc_region_t;
+
+
+extern void
+alloc_region_init(
+	_out_ alloc_region_t* region
+	);
+
+
+extern void
+alloc_region_free(
+	_inout_ alloc_region_t* region
+	);
+
+
+extern _alloc_func_ void*
+alloc_region_alloc(
+	_inout_ alloc_region_t* region,
+	alloc_t size,
+	int zero
+	);
+
+
+extern void
+alloc_region_release(
+	_inout_ alloc_region_t* region,
+	_opaque_ void* ptr,
+	alloc_t size
+	);
+
+
+typedef struct alloc_vec
+{
+	void* data;
+	alloc_t count;
+	alloc_t elem_size;
+	alloc_t committed;
+	alloc_t reserved;
+}
+alloc_vec_t;
+
+
+extern void
+alloc_vec_init(
+	_out_ alloc_vec_t* vec,
+	alloc_t elem_size,
+	alloc_t max_count
+	);
+
+
+extern void
+alloc_vec_free(
+	_inout_ alloc_vec_t* vec
+	);
+
+
+extern _warn_unused_result_ bool
+alloc_vec_resize(
+	_inout_ alloc_vec_t* vec,
+	alloc_t count
+	);
+
+
+extern _warn_unused_result_ void*
+alloc_vec_push(
+	_inout_ alloc_vec_t* vec,
+	alloc_t count
+	);
+
+
+extern void
+alloc_vec_pop(
+	_inout_ alloc_vec_t* vec,
+	alloc_t count
+	);
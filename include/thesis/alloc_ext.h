@@ -234,6 +234,33 @@ alloc_handle_get_flags_u(
 }
 
 
+_inline_ void
+alloc_get_stats(
+	_out_ alloc_handle_stats_t* stats
+	)
+{
+	alloc_get_stats_s(alloc_get_global_state(), stats);
+}
+
+
+_inline_ bool
+alloc_dump_stats(
+	const char* path
+	)
+{
+	return alloc_dump_stats_s(alloc_get_global_state(), path);
+}
+
+
+_inline_ void
+alloc_purge(
+	void
+	)
+{
+	alloc_purge_s(alloc_get_global_state());
+}
+
+
 _inline_ void*
 alloc_alloc_s(
 	_in_ alloc_state* state,
@@ -318,6 +345,102 @@ alloc_free_u(
 }
 
 
+_inline_ bool
+alloc_alloc_batch_s(
+	_in_ alloc_state* state,
+	_out_ void** ptrs,
+	alloc_t count,
+	alloc_t size,
+	int zero
+	)
+{
+	return alloc_alloc_batch_h(alloc_get_handle_s(state, size), ptrs, count, size, zero);
+}
+
+
+_inline_ bool
+alloc_alloc_batch_us(
+	_in_ alloc_state* state,
+	_out_ void** ptrs,
+	alloc_t count,
+	alloc_t size,
+	int zero
+	)
+{
+	return alloc_alloc_batch_uh(alloc_get_handle_s(state, size), ptrs, count, size, zero);
+}
+
+
+_inline_ bool
+alloc_alloc_batch(
+	_out_ void** ptrs,
+	alloc_t count,
+	alloc_t size,
+	int zero
+	)
+{
+	return alloc_alloc_batch_h(alloc_get_handle(size), ptrs, count, size, zero);
+}
+
+
+_inline_ bool
+alloc_alloc_batch_u(
+	_out_ void** ptrs,
+	alloc_t count,
+	alloc_t size,
+	int zero
+	)
+{
+	return alloc_alloc_batch_uh(alloc_get_handle(size), ptrs, count, size, zero);
+}
+
+
+_inline_ void
+alloc_free_batch_s(
+	_in_ alloc_state* state,
+	void* const* ptrs,
+	alloc_t count,
+	alloc_t size
+	)
+{
+	alloc_free_batch_h(alloc_get_handle_s(state, size), ptrs, count, size);
+}
+
+
+_inline_ void
+alloc_free_batch_us(
+	_in_ alloc_state* state,
+	void* const* ptrs,
+	alloc_t count,
+	alloc_t size
+	)
+{
+	alloc_free_batch_uh(alloc_get_handle_s(state, size), ptrs, count, size);
+}
+
+
+_inline_ void
+alloc_free_batch(
+	void* const* ptrs,
+	alloc_t count,
+	alloc_t size
+	)
+{
+	alloc_free_batch_h(alloc_get_handle(size), ptrs, count, size);
+}
+
+
+_inline_ void
+alloc_free_batch_u(
+	void* const* ptrs,
+	alloc_t count,
+	alloc_t size
+	)
+{
+	alloc_free_batch_uh(alloc_get_handle(size), ptrs, count, size);
+}
+
+
 _inline_ void*
 alloc_realloc_s(
 	_in_ alloc_state* old_state,
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <thesis/str.h>
+#include <thesis/alloc.h>
 #include <thesis/macro.h>
 
 #define CGLM_FORCE_RADIANS
@@ -51,6 +52,8 @@ mesh_t;
 
 typedef struct model
 {
+	alloc_region_t region;
+
 	material_t* materials;
 	mesh_t* meshes;
 
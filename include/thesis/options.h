@@ -54,6 +54,7 @@ options_set_default(
 	);
 
 
+/* Only valid inside a sync_rcu_read_lock section */
 extern const str_t
 options_get(
 	options_t options,
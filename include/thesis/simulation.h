@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <thesis/alloc.h>
 #include <thesis/event.h>
 #include <thesis/model.h>
 
@@ -96,6 +97,7 @@ simulation_add_entity(
 extern simulation_entity_data_t*
 simulation_get_entity_data(
 	simulation_t simulation,
+	alloc_arena_t* arena,
 	uint32_t* data_count
 	);
 
@@ -107,6 +109,19 @@ simulation_get_models(
 	);
 
 
+extern simulation_camera_t
+simulation_get_camera(
+	simulation_t simulation
+	);
+
+
+extern void
+simulation_set_camera(
+	simulation_t simulation,
+	simulation_camera_t camera
+	);
+
+
 extern void
 simulation_stop(
 	simulation_t simulation
@@ -16,12 +16,39 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 #include <pthread.h>
 #include <semaphore.h>
 
+#ifndef SYNC_FUTEX
+	#define SYNC_FUTEX 0
+#endif
 
-typedef pthread_mutex_t sync_mtx_t;
+#if SYNC_FUTEX && !defined(__linux__)
+	#error "SYNC_FUTEX requires Linux"
+#endif
+
+
+extern void
+sync_pause(
+	void
+	);
+
+
+#if SYNC_FUTEX
+	typedef struct sync_mtx
+	{
+		uint32_t _Atomic state;
+	}
+	sync_mtx_t;
+
+	#define SYNC_MTX_INIT { .state = 0 }
+#else
+	typedef pthread_mutex_t sync_mtx_t;
+
+	#define SYNC_MTX_INIT PTHREAD_MUTEX_INITIALIZER
+#endif
 
 
 extern void
@@ -99,7 +126,15 @@ sync_rwlock_unlock(
 	);
 
 
-typedef pthread_cond_t sync_cond_t;
+#if SYNC_FUTEX
+	typedef struct sync_cond
+	{
+		uint32_t _Atomic seq;
+	}
+	sync_cond_t;
+#else
+	typedef pthread_cond_t sync_cond_t;
+#endif
 
 
 extern void
@@ -127,7 +162,22 @@ sync_cond_wake(
 	);
 
 
-typedef sem_t sync_sem_t;
+extern void
+sync_cond_wake_all(
+	sync_cond_t* cond
+	);
+
+
+#if SYNC_FUTEX
+	typedef struct sync_sem
+	{
+		uint32_t _Atomic value;
+		uint32_t _Atomic waiters;
+	}
+	sync_sem_t;
+#else
+	typedef sem_t sync_sem_t;
+#endif
 
 
 extern void
@@ -149,6 +199,12 @@ sync_sem_wait(
 	);
 
 
+extern bool
+sync_sem_try_wait(
+	sync_sem_t* sem
+	);
+
+
 extern void
 sync_sem_timed_wait(
 	sync_sem_t* sem,
@@ -160,3 +216,220 @@ extern void
 sync_sem_post(
 	sync_sem_t* sem
 	);
+
+
+extern void
+sync_sem_post_n(
+	sync_sem_t* sem,
+	uint32_t count
+	);
+
+
+#if SYNC_FUTEX
+	typedef struct sync_event
+	{
+		uint32_t _Atomic state;
+	}
+	sync_event_t;
+#else
+	typedef struct sync_event
+	{
+		sync_mtx_t mtx;
+		sync_cond_t cond;
+		uint32_t state;
+	}
+	sync_event_t;
+#endif
+
+
+extern void
+sync_event_init(
+	sync_event_t* event
+	);
+
+
+extern void
+sync_event_free(
+	sync_event_t* event
+	);
+
+
+extern void
+sync_event_set(
+	sync_event_t* event
+	);
+
+
+extern void
+sync_event_reset(
+	sync_event_t* event
+	);
+
+
+extern bool
+sync_event_is_set(
+	sync_event_t* event
+	);
+
+
+extern void
+sync_event_wait(
+	sync_event_t* event
+	);
+
+
+#if SYNC_FUTEX
+	typedef struct sync_latch
+	{
+		uint32_t _Atomic count;
+	}
+	sync_latch_t;
+#else
+	typedef struct sync_latch
+	{
+		sync_mtx_t mtx;
+		sync_cond_t cond;
+		uint32_t count;
+	}
+	sync_latch_t;
+#endif
+
+
+extern void
+sync_latch_init(
+	sync_latch_t* latch,
+	uint32_t count
+	);
+
+
+extern void
+sync_latch_free(
+	sync_latch_t* latch
+	);
+
+
+extern void
+sync_latch_count_down(
+	sync_latch_t* latch,
+	uint32_t count
+	);
+
+
+extern bool
+sync_latch_try_wait(
+	sync_latch_t* latch
+	);
+
+
+extern void
+sync_latch_wait(
+	sync_latch_t* latch
+	);
+
+
+typedef struct sync_seqlock
+{
+	uint32_t _Atomic seq;
+}
+sync_seqlock_t;
+
+#define SYNC_SEQLOCK_INIT { .seq = 0 }
+
+
+extern void
+sync_seqlock_init(
+	sync_seqlock_t* lock
+	);
+
+
+extern void
+sync_seqlock_free(
+	sync_seqlock_t* lock
+	);
+
+
+extern void
+sync_seqlock_write_lock(
+	sync_seqlock_t* lock
+	);
+
+
+extern void
+sync_seqlock_write_unlock(
+	sync_seqlock_t* lock
+	);
+
+
+extern uint32_t
+sync_seqlock_read_begin(
+	sync_seqlock_t* lock
+	);
+
+
+extern bool
+sync_seqlock_read_retry(
+	sync_seqlock_t* lock,
+	uint32_t seq
+	);
+
+
+extern void
+sync_seqlock_read(
+	sync_seqlock_t* lock,
+	void* dst,
+	const void* src,
+	size_t size
+	);
+
+
+extern void
+sync_seqlock_write(
+	sync_seqlock_t* lock,
+	void* dst,
+	const void* src,
+	size_t size
+	);
+
+
+typedef void
+(*sync_rcu_fn_t)(
+	void* data
+	);
+
+
+extern void
+sync_rcu_read_lock(
+	void
+	);
+
+
+extern void
+sync_rcu_read_unlock(
+	void
+	);
+
+
+extern void
+sync_rcu_synchronize(
+	void
+	);
+
+
+extern void
+sync_rcu_call(
+	sync_rcu_fn_t fn,
+	void* data
+	);
+
+
+extern void
+sync_rcu_free(
+	void* ptr,
+	size_t size
+	);
+
+
+extern void
+sync_rcu_barrier(
+	void
+	);
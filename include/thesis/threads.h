@@ -17,6 +17,7 @@
 #pragma once
 
 #include <thesis/sync.h>
+#include <thesis/alloc.h>
 
 
 typedef pthread_t thread_t;
@@ -120,11 +121,91 @@ thread_sleep(
 	);
 
 
+extern uint32_t
+thread_get_cpu_count(
+	void
+	);
+
+
+extern void
+thread_set_spin_ns(
+	uint64_t ns
+	);
+
+
+extern uint64_t
+thread_get_spin_ns(
+	void
+	);
+
+
+extern void
+thread_set_name(
+	thread_t thread,
+	const char* name
+	);
+
+
+extern bool
+thread_set_affinity(
+	thread_t thread,
+	const uint32_t* cpus,
+	uint32_t count
+	);
+
+
+typedef struct thread_cpu
+{
+	uint32_t id;
+	uint32_t package;
+	uint32_t core;
+	uint32_t smt;
+	uint32_t l3;
+}
+thread_cpu_t;
+
+
+typedef struct thread_topology
+{
+	thread_cpu_t* cpus;
+	uint32_t cpu_count;
+	uint32_t core_count;
+	uint32_t l3_count;
+}
+thread_topology_t;
+
+
+extern void
+thread_topology_init(
+	thread_topology_t* topology
+	);
+
+
+extern void
+thread_topology_free(
+	thread_topology_t* topology
+	);
+
+
+extern uint32_t
+thread_topology_get_core_cpus(
+	const thread_topology_t* topology,
+	uint32_t core,
+	uint32_t* cpus
+	);
+
+
+extern bool
+thread_set_core_affinity(
+	thread_t thread,
+	const thread_topology_t* topology,
+	uint32_t core
+	);
+
+
 typedef struct threads
 {
-	thread_t* threads;
-	uint32_t used;
-	uint32_t size;
+	alloc_vec_t threads;
 }
 threads_t;
 
@@ -175,14 +256,40 @@ threads_cancel_all_async(
 	);
 
 
+typedef enum thread_priority : uint32_t
+{
+	THREAD_PRIORITY_CRITICAL,
+	THREAD_PRIORITY_NORMAL,
+	THREAD_PRIORITY_BACKGROUND,
+	MACRO_ENUM_BITS(THREAD_PRIORITY)
+}
+thread_priority_t;
+
+
+typedef struct thread_pool_cell thread_pool_cell_t;
+
+
+typedef struct thread_pool_queue
+{
+	thread_pool_cell_t* ring;
+	alloc_t _Atomic head;
+	alloc_t _Atomic tail;
+
+	alloc_vec_t queue;
+	alloc_t queue_head;
+	alloc_t _Atomic queue_count;
+}
+thread_pool_queue_t;
+
+
 typedef struct thread_pool
 {
 	sync_sem_t sem;
 	sync_mtx_t mtx;
 
-	thread_data_t* queue;
-	uint32_t used;
-	uint32_t size;
+	uint32_t _Atomic idle_count;
+
+	thread_pool_queue_t queues[THREAD_PRIORITY__COUNT];
 }
 thread_pool_t;
 
@@ -231,6 +338,56 @@ thread_pool_add(
 	);
 
 
+extern void
+thread_pool_add_priority_u(
+	thread_pool_t* pool,
+	thread_data_t data,
+	thread_priority_t priority
+	);
+
+
+extern void
+thread_pool_add_priority(
+	thread_pool_t* pool,
+	thread_data_t data,
+	thread_priority_t priority
+	);
+
+
+extern void
+thread_pool_add_batch_u(
+	thread_pool_t* pool,
+	const thread_data_t* tasks,
+	alloc_t count
+	);
+
+
+extern void
+thread_pool_add_batch(
+	thread_pool_t* pool,
+	const thread_data_t* tasks,
+	alloc_t count
+	);
+
+
+extern void
+thread_pool_add_batch_priority_u(
+	thread_pool_t* pool,
+	const thread_data_t* tasks,
+	alloc_t count,
+	thread_priority_t priority
+	);
+
+
+extern void
+thread_pool_add_batch_priority(
+	thread_pool_t* pool,
+	const thread_data_t* tasks,
+	alloc_t count,
+	thread_priority_t priority
+	);
+
+
 extern bool
 thread_pool_try_work_u(
 	thread_pool_t* pool
@@ -253,3 +410,214 @@ extern void
 thread_pool_work(
 	thread_pool_t* pool
 	);
+
+
+extern bool
+thread_pool_should_yield(
+	thread_pool_t* pool
+	);
+
+
+extern bool
+thread_pool_yield_u(
+	thread_pool_t* pool
+	);
+
+
+extern bool
+thread_pool_yield(
+	thread_pool_t* pool
+	);
+
+
+typedef struct thread_sched_worker thread_sched_worker_t;
+
+
+typedef struct thread_sched
+{
+	thread_pool_t pool;
+
+	sync_sem_t sem;
+	uint32_t _Atomic idle_count;
+
+	thread_sched_worker_t* workers;
+	uint32_t worker_count;
+
+	threads_t threads;
+}
+thread_sched_t;
+
+
+extern void
+thread_sched_init(
+	thread_sched_t* sched,
+	uint32_t worker_count
+	);
+
+
+extern void
+thread_sched_free(
+	thread_sched_t* sched
+	);
+
+
+extern void
+thread_sched_pin(
+	thread_sched_t* sched,
+	const thread_topology_t* topology,
+	uint32_t first_core
+	);
+
+
+extern void
+thread_sched_add(
+	thread_sched_t* sched,
+	thread_data_t data
+	);
+
+
+extern void
+thread_sched_add_batch(
+	thread_sched_t* sched,
+	const thread_data_t* tasks,
+	uint32_t count
+	);
+
+
+extern bool
+thread_sched_try_work(
+	thread_sched_t* sched
+	);
+
+
+typedef struct thread_counter
+{
+	uint32_t _Atomic value;
+	uint32_t _Atomic waiter_count;
+	sync_sem_t sem;
+}
+thread_counter_t;
+
+
+extern void
+thread_counter_init(
+	thread_counter_t* counter,
+	uint32_t value
+	);
+
+
+extern void
+thread_counter_free(
+	thread_counter_t* counter
+	);
+
+
+extern void
+thread_counter_add(
+	thread_counter_t* counter,
+	uint32_t value
+	);
+
+
+extern void
+thread_counter_sub(
+	thread_counter_t* counter,
+	uint32_t value
+	);
+
+
+extern bool
+thread_counter_is_done(
+	thread_counter_t* counter
+	);
+
+
+extern void
+thread_counter_wait(
+	thread_counter_t* counter,
+	thread_sched_t* sched
+	);
+
+
+typedef struct thread_job thread_job_t;
+
+
+extern thread_job_t*
+thread_job_init(
+	thread_sched_t* sched,
+	thread_data_t data,
+	thread_counter_t* counter
+	);
+
+
+extern void
+thread_job_then(
+	thread_job_t* job,
+	thread_job_t* continuation
+	);
+
+
+extern void
+thread_job_submit(
+	thread_job_t* job
+	);
+
+
+typedef enum thread_for_flag : uint32_t
+{
+	THREAD_FOR_FLAG_NONE					= 0,
+	THREAD_FOR_FLAG_STATIC					= 1 << 0,
+	THREAD_FOR_FLAG_CALLER_RUNS				= 1 << 1,
+}
+thread_for_flag_t;
+
+
+typedef void
+(*thread_for_fn_t)(
+	void* data,
+	uint32_t begin,
+	uint32_t end
+	);
+
+
+typedef void
+(*thread_reduce_fn_t)(
+	void* data,
+	uint32_t begin,
+	uint32_t end,
+	void* partial
+	);
+
+
+typedef void
+(*thread_combine_fn_t)(
+	void* data,
+	void* result,
+	const void* partial
+	);
+
+
+extern void
+thread_parallel_for(
+	thread_sched_t* sched,
+	uint32_t count,
+	uint32_t grain,
+	thread_for_flag_t flags,
+	thread_for_fn_t fn,
+	void* data
+	);
+
+
+extern void
+thread_parallel_reduce(
+	thread_sched_t* sched,
+	uint32_t count,
+	uint32_t grain,
+	thread_for_flag_t flags,
+	thread_reduce_fn_t fn,
+	thread_combine_fn_t combine_fn,
+	void* data,
+	const void* identity,
+	void* result,
+	alloc_t result_size
+	);
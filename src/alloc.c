@@ -29,21 +29,45 @@
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <stdatomic.h>
 
 #ifndef _packed_
 	#define _packed_ __attribute__((packed))
 #endif
 
 
+#define ALLOC_HUGE_PAGE_SIZE MACRO_POWER_OF_2(21)
+
+
+private alloc_t
+alloc_get_virtual_size(
+	alloc_t size,
+	alloc_page_flag_t flags
+	)
+{
+	if(flags & ALLOC_PAGE_FLAG_HUGE)
+	{
+		return MACRO_ALIGN_UP(size, ALLOC_HUGE_PAGE_SIZE - 1);
+	}
+
+	return size;
+}
+
+
 #ifdef _WIN32
 	#include <windows.h>
 
 
 	_alloc_func_ void*
-	alloc_alloc_virtual(
-		alloc_t size
+	alloc_alloc_virtual_flags(
+		alloc_t size,
+		alloc_page_flag_t flags
 		)
 	{
+		(void) flags;
+
 		if(!size)
 		{
 			return NULL;
@@ -55,12 +79,14 @@
 
 
 	void
-	alloc_free_virtual(
+	alloc_free_virtual_flags(
 		_opaque_ void* ptr,
-		alloc_t size
+		alloc_t size,
+		alloc_page_flag_t flags
 		)
 	{
 		(void) size;
+		(void) flags;
 
 		if(!ptr)
 		{
@@ -73,15 +99,18 @@
 
 
 	_alloc_func_ void*
-	alloc_alloc_virtual_aligned(
+	alloc_alloc_virtual_aligned_flags(
 		alloc_t size,
 		alloc_t alignment,
+		alloc_page_flag_t flags,
 		_out_ void** ptr
 		)
 	{
 		assert_ge(alignment, 1);
 		assert_eq(MACRO_IS_POWER_OF_2(alignment), 1);
 
+		(void) flags;
+
 		if(!size)
 		{
 			*ptr = NULL;
@@ -114,45 +143,268 @@
 
 
 	void
-	alloc_free_virtual_aligned(
+	alloc_free_virtual_aligned_flags(
 		_opaque_ void* ptr,
 		alloc_t size,
-		alloc_t alignment
+		alloc_t alignment,
+		alloc_page_flag_t flags
+		)
+	{
+		alloc_free_virtual_flags(ptr, size + alignment - 1, flags);
+	}
+
+
+	private bool
+	alloc_remap_virtual(
+		void* dst,
+		_opaque_ void* src,
+		alloc_t old_size,
+		alloc_t new_size
+		)
+	{
+		(void) dst;
+		(void) src;
+		(void) old_size;
+		(void) new_size;
+
+		return false;
+	}
+
+
+	private bool
+	alloc_move_virtual(
+		void* dst,
+		void* src,
+		alloc_t size
+		)
+	{
+		(void) dst;
+		(void) src;
+		(void) size;
+
+		return false;
+	}
+
+
+	private void*
+	alloc_reserve_virtual(
+		alloc_t size
+		)
+	{
+		return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+	}
+
+
+	private bool
+	alloc_commit_virtual(
+		void* ptr,
+		alloc_t size
+		)
+	{
+		return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+	}
+
+
+	private void
+	alloc_decommit_virtual(
+		void* ptr,
+		alloc_t size
+		)
+	{
+		BOOL status = VirtualFree(ptr, size, MEM_DECOMMIT);
+		assert_neq(status, 0);
+	}
+
+
+	private bool
+	alloc_purge_virtual(
+		void* ptr,
+		alloc_t size
 		)
 	{
-		alloc_free_virtual(ptr, size + alignment - 1);
+		alloc_decommit_virtual(ptr, size);
+
+		return alloc_commit_virtual(ptr, size);
 	}
 
 
 #else
+	#include <unistd.h>
 	#include <sys/mman.h>
+	#include <sys/syscall.h>
 
+	#ifdef __linux__
+		#include <sched.h>
+		#include <linux/mempolicy.h>
+	#endif
 
-	_alloc_func_ void*
-	alloc_alloc_virtual(
-		alloc_t size
+
+	private alloc_t
+	alloc_get_virtual_alignment(
+		alloc_t alignment,
+		alloc_page_flag_t flags
 		)
 	{
-		if(!size)
+		if(flags & ALLOC_PAGE_FLAG_HUGE)
 		{
-			return NULL;
+			return MACRO_MAX(alignment, ALLOC_HUGE_PAGE_SIZE);
+		}
+
+		return alignment;
+	}
+
+
+	private void
+	alloc_advise_virtual(
+		void* ptr,
+		alloc_t size,
+		alloc_page_flag_t flags
+		)
+	{
+	#ifdef MADV_HUGEPAGE
+		if(flags & ALLOC_PAGE_FLAG_HUGE)
+		{
+			(void) madvise(ptr, size, MADV_HUGEPAGE);
+		}
+	#endif
+
+	#if defined(__linux__) && defined(SYS_mbind)
+		if(flags & ALLOC_PAGE_FLAG_NODE)
+		{
+			unsigned long node_mask = 1UL << ALLOC_PAGE_FLAG_GET_NODE(flags);
+
+			(void) syscall(SYS_mbind, ptr, size, MPOL_PREFERRED,
+				&node_mask, sizeof(node_mask) * 8 + 1, 0);
+		}
+	#endif
+	}
+
+
+	private void*
+	alloc_map_virtual(
+		alloc_t size,
+		int prot,
+		alloc_page_flag_t flags
+		)
+	{
+		int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+	#ifdef MAP_POPULATE
+		if(flags & ALLOC_PAGE_FLAG_POPULATE)
+		{
+			map_flags |= MAP_POPULATE;
+		}
+	#endif
+
+	#ifdef MAP_HUGETLB
+		if(flags & ALLOC_PAGE_FLAG_HUGE)
+		{
+			void* ptr = mmap(NULL, size, prot, map_flags | MAP_HUGETLB, -1, 0);
+			if(ptr != MAP_FAILED)
+			{
+				return ptr;
+			}
 		}
+	#endif
 
-		void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
-			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		void* ptr = mmap(NULL, size, prot, map_flags, -1, 0);
 		if(ptr == MAP_FAILED)
 		{
 			return NULL;
 		}
 
+		alloc_advise_virtual(ptr, size, flags);
+
 		return ptr;
 	}
 
 
+	private bool
+	alloc_commit_virtual_flags(
+		void* ptr,
+		alloc_t size,
+		alloc_page_flag_t flags
+		)
+	{
+	#ifdef MAP_HUGETLB
+		if(flags & ALLOC_PAGE_FLAG_HUGE)
+		{
+			int map_flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED;
+
+			void* new_ptr = mmap(ptr, size, PROT_READ | PROT_WRITE,
+				map_flags | MAP_HUGETLB, -1, 0);
+			if(new_ptr == MAP_FAILED)
+			{
+				/* A failed MAP_FIXED may have already unmapped the range */
+				new_ptr = mmap(ptr, size, PROT_READ | PROT_WRITE, map_flags, -1, 0);
+				if(new_ptr == MAP_FAILED)
+				{
+					return false;
+				}
+			}
+
+			alloc_advise_virtual(ptr, size, flags);
+
+			return true;
+		}
+	#endif
+
+		if(mprotect(ptr, size, PROT_READ | PROT_WRITE))
+		{
+			return false;
+		}
+
+		alloc_advise_virtual(ptr, size, flags);
+
+		return true;
+	}
+
+
+	private void
+	alloc_populate_virtual(
+		void* ptr,
+		alloc_t size
+		)
+	{
+	#ifdef MADV_POPULATE_WRITE
+		if(!madvise(ptr, size, MADV_POPULATE_WRITE))
+		{
+			return;
+		}
+	#endif
+
+		volatile uint8_t* page = ptr;
+		volatile uint8_t* page_end = page + size;
+
+		for(; page < page_end; page += alloc_get_page_size())
+		{
+			*page = 0;
+		}
+	}
+
+
+	_alloc_func_ void*
+	alloc_alloc_virtual_flags(
+		alloc_t size,
+		alloc_page_flag_t flags
+		)
+	{
+		if(!size)
+		{
+			return NULL;
+		}
+
+		size = alloc_get_virtual_size(size, flags);
+
+		return alloc_map_virtual(size, PROT_READ | PROT_WRITE, flags);
+	}
+
+
 	void
-	alloc_free_virtual(
+	alloc_free_virtual_flags(
 		_opaque_ void* ptr,
-		alloc_t size
+		alloc_t size,
+		alloc_page_flag_t flags
 		)
 	{
 		if(!ptr)
@@ -160,15 +412,18 @@
 			return;
 		}
 
+		size = alloc_get_virtual_size(size, flags);
+
 		int status = munmap((void*) ptr, size);
 		assert_eq(status, 0);
 	}
 
 
 	_alloc_func_ void*
-	alloc_alloc_virtual_aligned(
+	alloc_alloc_virtual_aligned_flags(
 		alloc_t size,
 		alloc_t alignment,
+		alloc_page_flag_t flags,
 		_out_ void** ptr
 		)
 	{
@@ -181,44 +436,218 @@
 			return NULL;
 		}
 
+		size = alloc_get_virtual_size(size, flags);
+		alignment = alloc_get_virtual_alignment(alignment, flags);
+
 		alloc_t mask = alignment - 1;
 		alloc_t actual_size = size + mask;
 
-		void* real_ptr = mmap(NULL, actual_size, PROT_NONE,
-			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-		if(real_ptr == MAP_FAILED)
+		void* real_ptr = alloc_map_virtual(actual_size, PROT_NONE,
+			flags & ~(ALLOC_PAGE_FLAG_HUGE | ALLOC_PAGE_FLAG_POPULATE));
+		if(!real_ptr)
 		{
 			return NULL;
 		}
 
 		void* aligned_ptr = MACRO_ALIGN_UP(real_ptr, mask);
 
-		if(mprotect(aligned_ptr, size, PROT_READ | PROT_WRITE))
+		if(!alloc_commit_virtual_flags(aligned_ptr, size, flags))
 		{
-			alloc_free_virtual(real_ptr, actual_size);
+			alloc_free_virtual_flags(real_ptr, actual_size, ALLOC_PAGE_FLAG_NONE);
 			return NULL;
 		}
 
+		if(flags & ALLOC_PAGE_FLAG_POPULATE)
+		{
+			alloc_populate_virtual(aligned_ptr, size);
+		}
+
 		*ptr = aligned_ptr;
 		return real_ptr;
 	}
 
 
 	void
-	alloc_free_virtual_aligned(
+	alloc_free_virtual_aligned_flags(
 		_opaque_ void* real_ptr,
 		alloc_t size,
-		alloc_t alignment
+		alloc_t alignment,
+		alloc_page_flag_t flags
 		)
 	{
-		alloc_free_virtual(real_ptr, size + alignment - 1);
+		size = alloc_get_virtual_size(size, flags);
+		alignment = alloc_get_virtual_alignment(alignment, flags);
+
+		alloc_free_virtual_flags(real_ptr, size + alignment - 1, ALLOC_PAGE_FLAG_NONE);
 	}
 
 
-	#include <unistd.h>
+	private void
+	alloc_recommit_virtual(
+		void* ptr,
+		alloc_t size
+		)
+	{
+		/* A failed MREMAP_FIXED may have already unmapped the destination */
+		void* new_ptr = mmap(ptr, size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+		hard_assert_eq(new_ptr, ptr);
+	}
+
+
+	private bool
+	alloc_remap_virtual(
+		void* dst,
+		_opaque_ void* src,
+		alloc_t old_size,
+		alloc_t new_size
+		)
+	{
+	#ifdef MREMAP_FIXED
+		void* ptr = mremap((void*) src, old_size, new_size,
+			MREMAP_MAYMOVE | MREMAP_FIXED, dst);
+		if(ptr != MAP_FAILED)
+		{
+			return true;
+		}
+
+		alloc_recommit_virtual(dst, new_size);
+
+		return false;
+	#else
+		(void) dst;
+		(void) src;
+		(void) old_size;
+		(void) new_size;
+
+		return false;
+	#endif
+	}
+
+
+	private bool
+	alloc_move_virtual(
+		void* dst,
+		void* src,
+		alloc_t size
+		)
+	{
+	#ifdef MREMAP_DONTUNMAP
+		void* ptr = mremap(src, size, size,
+			MREMAP_MAYMOVE | MREMAP_FIXED | MREMAP_DONTUNMAP, dst);
+		if(ptr != MAP_FAILED)
+		{
+			return true;
+		}
+
+		alloc_recommit_virtual(dst, size);
+	#endif
+
+		if(!alloc_remap_virtual(dst, src, size, size))
+		{
+			return false;
+		}
+
+		void* src_ptr = mmap(src, size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+		hard_assert_eq(src_ptr, src);
+
+		return true;
+	}
+
+
+	private void*
+	alloc_reserve_virtual(
+		alloc_t size
+		)
+	{
+		void* ptr = mmap(NULL, size, PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if(ptr == MAP_FAILED)
+		{
+			return NULL;
+		}
+
+		return ptr;
+	}
+
+
+	private bool
+	alloc_commit_virtual(
+		void* ptr,
+		alloc_t size
+		)
+	{
+		return !mprotect(ptr, size, PROT_READ | PROT_WRITE);
+	}
+
+
+	private void
+	alloc_decommit_virtual(
+		void* ptr,
+		alloc_t size
+		)
+	{
+		void* new_ptr = mmap(ptr, size, PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+		hard_assert_eq(new_ptr, ptr);
+	}
+
+
+	private bool
+	alloc_purge_virtual(
+		void* ptr,
+		alloc_t size
+		)
+	{
+		return !madvise(ptr, size, MADV_DONTNEED);
+	}
 #endif
 
 
+_alloc_func_ void*
+alloc_alloc_virtual(
+	alloc_t size
+	)
+{
+	return alloc_alloc_virtual_flags(size, ALLOC_PAGE_FLAG_NONE);
+}
+
+
+void
+alloc_free_virtual(
+	_opaque_ void* ptr,
+	alloc_t size
+	)
+{
+	alloc_free_virtual_flags(ptr, size, ALLOC_PAGE_FLAG_NONE);
+}
+
+
+_alloc_func_ void*
+alloc_alloc_virtual_aligned(
+	alloc_t size,
+	alloc_t alignment,
+	_out_ void** ptr
+	)
+{
+	return alloc_alloc_virtual_aligned_flags(
+		size, alignment, ALLOC_PAGE_FLAG_NONE, ptr);
+}
+
+
+void
+alloc_free_virtual_aligned(
+	_opaque_ void* real_ptr,
+	alloc_t size,
+	alloc_t alignment
+	)
+{
+	alloc_free_virtual_aligned_flags(
+		real_ptr, size, alignment, ALLOC_PAGE_FLAG_NONE);
+}
+
+
 _alloc_func_ void*
 alloc_realloc_virtual(
 	_opaque_ void* ptr,
@@ -237,6 +666,14 @@ alloc_realloc_virtual(
 		return alloc_alloc_virtual(new_size);
 	}
 
+#ifdef MREMAP_MAYMOVE
+	void* remapped_ptr = mremap((void*) ptr, old_size, new_size, MREMAP_MAYMOVE);
+	if(remapped_ptr != MAP_FAILED)
+	{
+		return remapped_ptr;
+	}
+#endif
+
 	void* new_ptr = alloc_alloc_virtual(new_size);
 	if(!new_ptr)
 	{
@@ -280,11 +717,14 @@ alloc_realloc_virtual_aligned(
 		return NULL;
 	}
 
-	void* aligned_old_ptr = MACRO_ALIGN_UP((void*) real_ptr, alignment);
+	void* aligned_old_ptr = MACRO_ALIGN_UP((void*) real_ptr, alignment - 1);
 	void* aligned_new_ptr = *new_ptr;
 
-	alloc_t copy_size = MACRO_MIN(old_size, new_size);
-	(void) memcpy(aligned_new_ptr, aligned_old_ptr, copy_size);
+	if(!alloc_remap_virtual(aligned_new_ptr, aligned_old_ptr, old_size, new_size))
+	{
+		alloc_t copy_size = MACRO_MIN(old_size, new_size);
+		(void) memcpy(aligned_new_ptr, aligned_old_ptr, copy_size);
+	}
 
 	alloc_free_virtual_aligned(real_ptr, old_size, alignment);
 
@@ -351,11 +791,16 @@ struct _packed_ alloc_2
 	alloc_2_t* next;
 	uint32_t real_ptr_off;
 	uint32_t alloc_size;
+	alloc_2_t* remote_next;
 	uint16_t used;
 	uint16_t count;
 	uint16_t free;
+	uint16_t remote;
 };
 
+static_assert(offsetof(alloc_2_t, remote) % sizeof(uint16_t) == 0,
+	"alloc_2_t remote misaligned");
+
 
 #define ALLOC_4_MAX UINT32_MAX
 
@@ -367,19 +812,42 @@ struct _packed_ alloc_4
 	alloc_4_t* next;
 	uint32_t real_ptr_off;
 	uint32_t alloc_size;
+	alloc_4_t* remote_next;
 	uint32_t used;
 	uint32_t count;
 	uint32_t free;
+	uint32_t remote;
 };
 
+static_assert(offsetof(alloc_4_t, remote) % sizeof(uint32_t) == 0,
+	"alloc_4_t remote misaligned");
 
-typedef struct alloc_handle_impl alloc_handle_impl_t;
 
+private _Atomic uint16_t*
+alloc_2_get_remote(
+	alloc_2_t* alloc
+	)
+{
+	return (void*) alloc + offsetof(alloc_2_t, remote);
+}
 
-typedef void*
-(*alloc_alloc_fn_t)(
-	alloc_handle_impl_t* handle,
-	alloc_t size,
+
+private _Atomic uint32_t*
+alloc_4_get_remote(
+	alloc_4_t* alloc
+	)
+{
+	return (void*) alloc + offsetof(alloc_4_t, remote);
+}
+
+
+typedef struct alloc_handle_impl alloc_handle_impl_t;
+
+
+typedef void*
+(*alloc_alloc_fn_t)(
+	alloc_handle_impl_t* handle,
+	alloc_t size,
 	int zero
 	);
 
@@ -393,6 +861,14 @@ typedef void
 	);
 
 
+typedef void
+(*alloc_remote_fn_t)(
+	alloc_handle_impl_t* handle,
+	void* block_ptr,
+	void* ptr
+	);
+
+
 struct alloc_handle_impl
 {
 	sync_mtx_t mtx;
@@ -405,11 +881,30 @@ struct alloc_handle_impl
 	alloc_t block_size;
 
 	alloc_handle_flag_t flags;
+	alloc_page_flag_t page_flags;
 
 	alloc_header_t* head;
+	alloc_header_t* full;
+
+	alloc_header_t* dirty;
+	alloc_header_t* clean;
+	alloc_t dirty_count;
+	alloc_t dirty_aged;
+	alloc_t clean_count;
+	alloc_t clean_aged;
 
 	alloc_alloc_fn_t alloc_fn;
 	alloc_free_fn_t free_fn;
+	alloc_remote_fn_t remote_fn;
+
+	void* _Atomic remote;
+
+	alloc_t peak_allocations;
+	alloc_t peak_blocks;
+	alloc_t locks;
+	alloc_t contended_locks;
+	alloc_t _Atomic virtual_bytes;
+	alloc_t _Atomic peak_virtual_bytes;
 };
 
 static_assert(sizeof(alloc_handle_t) == sizeof(alloc_handle_impl_t),
@@ -418,6 +913,25 @@ static_assert(sizeof(alloc_handle_t) == sizeof(alloc_handle_impl_t),
 
 #define ALLOC_DEFAULT_BLOCK_SIZE MACRO_POWER_OF_2(23)
 
+#ifndef ALLOC_DEFAULT_HANDLE_FLAGS
+	#define ALLOC_DEFAULT_HANDLE_FLAGS ALLOC_HANDLE_FLAG_LAZY_FREE
+#endif
+
+#ifndef ALLOC_DEFAULT_PAGE_FLAGS
+	#define ALLOC_DEFAULT_PAGE_FLAGS ALLOC_PAGE_FLAG_NONE
+#endif
+
+#ifndef ALLOC_DEFAULT_CLASS_STEPS
+	#define ALLOC_DEFAULT_CLASS_STEPS 1
+#endif
+
+#ifndef ALLOC_DEFAULT_ZERO_PURGE_SIZE
+	#define ALLOC_DEFAULT_ZERO_PURGE_SIZE MACRO_POWER_OF_2(18)
+#endif
+
+#define ALLOC_STEPPED_CLASS_SHIFT 4
+#define ALLOC_CLASS_COUNT_MAX (64 * ALLOC_CLASS_STEPS_MAX)
+
 private alloc_handle_info_t alloc_default_handle_info[] =
 (alloc_handle_info_t[])
 {
@@ -540,9 +1054,12 @@ private alloc_handle_info_t alloc_default_handle_info[] =
 private alloc_state_info_t alloc_default_state_info =
 (alloc_state_info_t)
 {
-	.handles = alloc_default_handle_info,
-	.handle_count = MACRO_ARRAY_LEN(alloc_default_handle_info),
-	.idx_fn = NULL
+	.handles = NULL,
+	.handle_count = 0,
+	.idx_fn = NULL,
+	.flags = ALLOC_DEFAULT_HANDLE_FLAGS,
+	.page_flags = ALLOC_DEFAULT_PAGE_FLAGS,
+	.class_steps = ALLOC_DEFAULT_CLASS_STEPS
 };
 
 
@@ -552,1075 +1069,3881 @@ private uint32_t alloc_page_size_shift;
 private const alloc_state* alloc_global_state;
 
 
+#ifndef ALLOC_NODE_MAX
+	#define ALLOC_NODE_MAX 8
+#endif
+
+#ifndef ALLOC_CPU_MAX
+	#define ALLOC_CPU_MAX 1024
+#endif
 
+static_assert(ALLOC_NODE_MAX <= 64, "ALLOC_NODE_MAX must fit in a node mask");
 
+private alloc_t alloc_node_count = 1;
+private alloc_t alloc_cpu_count;
+private uint8_t alloc_cpu_nodes[ALLOC_CPU_MAX];
+private sync_mtx_t alloc_node_mtx;
+private const alloc_state* _Atomic alloc_node_states[ALLOC_NODE_MAX];
 
-private assert_ctor void
-alloc_library_init(
-	void
-	)
-{
-#ifdef _WIN32
-	SYSTEM_INFO info;
-	GetSystemInfo(&info);
-	alloc_page_size = info.dwPageSize;
-#else
-	alloc_page_size = getpagesize();
-#endif
 
-	assert_neq(alloc_page_size, 0);
-	assert_true(MACRO_IS_POWER_OF_2(alloc_page_size));
+#define ALLOC_CACHE_MAX 32
+#define ALLOC_CACHE_MIN 4
+#define ALLOC_CACHE_BYTES MACRO_POWER_OF_2(15)
 
-	alloc_page_size_mask = alloc_page_size - 1;
-	alloc_page_size_shift = MACRO_LOG2(alloc_page_size);
 
-#ifndef ALLOC_DO_NOT_AUTO_INIT_GLOBAL_STATE
-	alloc_global_state = alloc_alloc_state(NULL);
-	assert_not_null(alloc_global_state);
-#endif
+typedef struct alloc_cache_bin
+{
+	uint32_t count;
+	uint32_t capacity;
+	void* ptrs[ALLOC_CACHE_MAX];
 }
+alloc_cache_bin_t;
 
 
-private assert_dtor void
-aloc_library_free(
-	void
-	)
+typedef struct alloc_cache
 {
-#ifndef ALLOC_DO_NOT_AUTO_INIT_GLOBAL_STATE
-	alloc_free_state(alloc_global_state);
-#endif
+	alloc_t bin_count;
+	alloc_cache_bin_t bins[];
 }
+alloc_cache_t;
 
 
-_const_func_ const alloc_state*
-alloc_get_global_state(
-	void
-	)
+private pthread_key_t alloc_cache_key;
+private _Thread_local alloc_cache_t* alloc_thread_cache;
+
+
+private void
+alloc_cache_key_fn(
+	void* data
+	);
+
+
+struct alloc_arena_chunk
 {
-	return alloc_global_state;
-}
+	alloc_arena_chunk_t* next;
+	alloc_t size;
+	uint8_t data[];
+};
 
 
-_const_func_ alloc_t
-alloc_get_page_size(
-	void
-	)
+private pthread_key_t alloc_arena_key;
+private _Thread_local alloc_arena_t alloc_thread_arena;
+
+
+private void
+alloc_arena_key_fn(
+	void* data
+	);
+
+
+#define ALLOC_POOL_DEFAULT_SLAB_SIZE MACRO_POWER_OF_2(14)
+#define ALLOC_POOL_CACHE_MAX_POOLS 32
+#define ALLOC_POOL_CACHE_COUNT 32
+#define ALLOC_POOL_NO_CACHE UINT32_MAX
+
+
+struct alloc_pool_slab
 {
-	return alloc_page_size;
-}
+	alloc_pool_slab_t* next;
+	uint8_t data[];
+};
 
 
-_const_func_ alloc_t
-alloc_get_default_block_size(
-	void
-	)
+typedef struct alloc_pool_cache
 {
-	return ALLOC_DEFAULT_BLOCK_SIZE;
+	alloc_pool_t* pool;
+	alloc_t generation;
+	void* head;
+	alloc_t count;
 }
+alloc_pool_cache_t;
 
 
-private void*
-aloc_alloc_1_fn(
-	alloc_handle_impl_t* handle,
-	alloc_t size,
-	int zero
-	)
+typedef struct alloc_pool_thread
 {
-	(void) size;
+	alloc_pool_cache_t caches[ALLOC_POOL_CACHE_MAX_POOLS];
+}
+alloc_pool_thread_t;
 
-	alloc_1_block_t* block = (void*) handle->head;
-	if(!block)
-	{
-		void* real_ptr = alloc_alloc_virtual_aligned(
-			handle->block_size, handle->block_size, (void**) &block);
-		if(!real_ptr)
-		{
-			return NULL;
-		}
 
-		/*
-		block->prev = NULL;
-		block->next = NULL;
-		*/
-		assert_lt((void*) block - (void*) real_ptr, UINT32_MAX);
-		block->real_ptr_off = (void*) block - (void*) real_ptr;
-		block->alloc_size = 1;
-		/*
-		block->count = 0;
-		block->free = 0;
-		*/
+private alloc_pool_t* _Atomic alloc_pool_registry[ALLOC_POOL_CACHE_MAX_POOLS];
+private _Atomic alloc_t alloc_pool_generation;
 
-		alloc_t i = 0;
-		alloc_1_t* alloc = block->allocs;
+private pthread_key_t alloc_pool_key;
+private _Thread_local alloc_pool_thread_t* alloc_thread_pools;
 
-		for(; i < handle->alloc_limit - 1; ++i, ++alloc)
-		{
-			alloc->next = i + 1;
-			/*
-			alloc->used = 0;
-			alloc->count = 0;
-			*/
-			alloc->free = UINT8_MAX;
-		}
 
-		alloc->next = UINT8_MAX;
-		/*
-		alloc->used = 0;
-		alloc->count = 0;
-		*/
-		alloc->free = UINT8_MAX;
+private void
+alloc_pool_key_fn(
+	void* data
+	);
 
-		++handle->allocators;
-		handle->head = (void*) block;
-	}
 
-	alloc_1_t* alloc = &block->allocs[block->free];
+#ifdef ALLOC_TRACE_FILE
 
-	++handle->allocations;
-	++block->count;
-	++alloc->count;
+#define ALLOC_TRACE_BUFFER_COUNT 4096
 
-	if(alloc->count == ALLOC_1_MAX)
-	{
-		if(block->count == ALLOC_1_MAX * handle->alloc_limit)
-		{
-			handle->head = (void*) block->next;
 
-			if(block->next)
-			{
-				block->next->prev = NULL;
-			}
+typedef struct alloc_trace_buffer
+{
+	uint32_t thread;
+	uint32_t count;
+	alloc_trace_record_t records[ALLOC_TRACE_BUFFER_COUNT];
+}
+alloc_trace_buffer_t;
 
-			block->prev = NULL;
-			block->next = NULL;
-		}
-		else
-		{
-			block->free = alloc->next;
-		}
-	}
 
-	if(alloc->free != UINT8_MAX)
-	{
-		uint8_t* ptr = alloc->data + alloc->free;
+private FILE* alloc_trace_file;
+private sync_mtx_t alloc_trace_mtx;
+private _Atomic uint32_t alloc_trace_thread_count;
+private pthread_key_t alloc_trace_key;
+private _Thread_local alloc_trace_buffer_t* alloc_thread_trace;
 
-#ifdef ALLOC_VALGRIND
-		VALGRIND_MALLOCLIKE_BLOCK(ptr, 1, 0, 0);
-#endif
 
-		alloc->free = *ptr;
+private void
+alloc_trace_flush(
+	alloc_trace_buffer_t* buffer
+	)
+{
+	if(!buffer->count)
+	{
+		return;
+	}
 
-		if(zero)
-		{
-			*ptr = 0;
-		}
+	sync_mtx_lock(&alloc_trace_mtx);
 
-		return ptr;
+	if(alloc_trace_file)
+	{
+		(void) fwrite(buffer->records, sizeof(*buffer->records),
+			buffer->count, alloc_trace_file);
 	}
 
-	uint8_t* ptr = alloc->data + alloc->used++;
-
-#ifdef ALLOC_VALGRIND
-	VALGRIND_MALLOCLIKE_BLOCK(ptr, 1, 0, 1);
-#endif
+	sync_mtx_unlock(&alloc_trace_mtx);
 
-	return ptr;
+	buffer->count = 0;
 }
 
 
 private void
-alloc_free_1_fn(
-	alloc_handle_impl_t* handle,
-	void* block_ptr,
-	void* ptr,
-	alloc_t size
+alloc_trace_key_fn(
+	void* data
 	)
 {
-	(void) size;
+	alloc_trace_buffer_t* buffer = data;
 
-	alloc_1_block_t* block = block_ptr;
-	alloc_1_t* alloc = &block->allocs[
-		((void*) ptr - (void*) block - sizeof(alloc_1_block_t))
-		/ sizeof(alloc_1_t)];
+	alloc_trace_flush(buffer);
+	alloc_free_virtual(buffer, sizeof(*buffer));
 
-	--handle->allocations;
-	--block->count;
-	--alloc->count;
+	alloc_thread_trace = NULL;
+}
 
-	if(
-		block->count == 0 &&
-		(
-			(handle->flags & ALLOC_HANDLE_FLAG_IMMEDIATE_FREE) ||
-			(
-				handle->allocators >= 2 &&
-				!(handle->flags & ALLOC_HANDLE_FLAG_DO_NOT_FREE) &&
-				handle->allocations <= ALLOC_1_MAX *
-					handle->alloc_limit * (handle->allocators - 2)
-			)
-		)
-		)
+
+private void
+alloc_trace(
+	alloc_trace_op_t op,
+	_opaque_ void* ptr,
+	alloc_t size
+	)
+{
+	alloc_trace_buffer_t* buffer = alloc_thread_trace;
+	if(!buffer)
 	{
-		if(block->prev)
+		buffer = alloc_alloc_virtual(sizeof(*buffer));
+		if(!buffer)
 		{
-			block->prev->next = block->next;
-		}
-		else
-		{
-			handle->head = (void*) block->next;
+			return;
 		}
 
-		if(block->next)
-		{
-			block->next->prev = block->prev;
-		}
+		buffer->thread = atomic_fetch_add_explicit(
+			&alloc_trace_thread_count, 1, memory_order_relaxed);
 
-		alloc_free_virtual_aligned((void*) block - block->real_ptr_off,
-			handle->block_size, handle->block_size);
+		int status = pthread_setspecific(alloc_trace_key, buffer);
+		assert_eq(status, 0);
 
-		--handle->allocators;
+		alloc_thread_trace = buffer;
 	}
-	else
-	{
-		if(alloc->count == ALLOC_1_MAX - 1)
-		{
-			alloc->next = block->free;
-			block->free = alloc - block->allocs;
-
-			if(block->count == ALLOC_1_MAX * handle->alloc_limit - 1)
-			{
-				if(handle->head)
-				{
-					handle->head->prev = block;
-				}
 
-				assert_null(block->prev);
-				block->next = (void*) handle->head;
-				handle->head = (void*) block;
-			}
-		}
+	struct timespec time;
+	int status = clock_gettime(CLOCK_MONOTONIC, &time);
+	hard_assert_eq(status, 0);
 
+	buffer->records[buffer->count++] =
+	(alloc_trace_record_t)
+	{
+		.time = time.tv_sec * 1000000000 + time.tv_nsec,
+		.ptr = (uintptr_t) ptr,
+		.size = size,
+		.thread = buffer->thread,
+		.op = op
+	};
 
-		*((uint8_t*) ptr) = alloc->free;
-		alloc->free = (uint8_t*) ptr - alloc->data;
+	if(buffer->count == ALLOC_TRACE_BUFFER_COUNT)
+	{
+		alloc_trace_flush(buffer);
 	}
 }
 
 
-private void*
-alloc_alloc_2_fn(
-	alloc_handle_impl_t* handle,
-	alloc_t size,
-	int zero
+private void
+alloc_trace_init(
+	void
 	)
 {
-	(void) size;
+	sync_mtx_init(&alloc_trace_mtx);
 
-	alloc_2_t* alloc = (void*) handle->head;
-	if(!alloc)
+	int status = pthread_key_create(&alloc_trace_key, alloc_trace_key_fn);
+	hard_assert_eq(status, 0);
+
+	alloc_trace_file = fopen(ALLOC_TRACE_FILE, "wb");
+	if(!alloc_trace_file)
 	{
-		void* real_ptr = alloc_alloc_virtual_aligned(
-			handle->block_size, handle->block_size, (void**) &alloc);
-		if(!real_ptr)
-		{
-			return NULL;
-		}
-
-		assert_lt((void*) alloc - (void*) real_ptr, UINT32_MAX);
-		alloc->real_ptr_off = (void*) alloc - (void*) real_ptr;
-		alloc->alloc_size = 2;
-
-		alloc->free = ALLOC_2_MAX;
-
-		++handle->allocators;
-		handle->head = (void*) alloc;
+		return;
 	}
 
-	++handle->allocations;
-	++alloc->count;
-
-	uint8_t* data = (uint8_t*) alloc + handle->padding;
-
-	if(alloc->count == handle->alloc_limit)
+	alloc_trace_header_t header =
 	{
-		handle->head = (void*) alloc->next;
+		.magic = ALLOC_TRACE_MAGIC,
+		.version = ALLOC_TRACE_VERSION
+	};
 
-		if(alloc->next)
-		{
-			alloc->next->prev = NULL;
-		}
+	(void) fwrite(&header, sizeof(header), 1, alloc_trace_file);
+}
 
-		alloc->next = NULL;
-	}
 
-	if(alloc->free != ALLOC_2_MAX)
+private void
+alloc_trace_free(
+	void
+	)
+{
+	alloc_trace_buffer_t* buffer = alloc_thread_trace;
+	if(buffer)
 	{
-		void* ptr = data + alloc->free * 2;
-
-#ifdef ALLOC_VALGRIND
-		VALGRIND_MALLOCLIKE_BLOCK(ptr, 2, 0, 0);
-#endif
-
-		(void) memcpy(&alloc->free, ptr, 2);
+		(void) pthread_setspecific(alloc_trace_key, NULL);
+		alloc_trace_key_fn(buffer);
+	}
 
-		if(zero)
-		{
-			(void) memset(ptr, 0, 2);
-		}
+	sync_mtx_lock(&alloc_trace_mtx);
 
-		return ptr;
+	if(alloc_trace_file)
+	{
+		(void) fclose(alloc_trace_file);
+		alloc_trace_file = NULL;
 	}
 
-	void* ptr = data + alloc->used++ * 2;
+	sync_mtx_unlock(&alloc_trace_mtx);
+}
 
-#ifdef ALLOC_VALGRIND
-	VALGRIND_MALLOCLIKE_BLOCK(ptr, 2, 0, 1);
+#else
+	#define alloc_trace(op, ptr, size)
 #endif
 
-	return ptr;
-}
+
+
 
 
 private void
-alloc_free_2_fn(
-	alloc_handle_impl_t* handle,
-	void* block_ptr,
-	void* ptr,
-	alloc_t size
+alloc_read_node_topology(
+	void
 	)
 {
-	(void) size;
-
-	alloc_2_t* alloc = block_ptr;
-
-	--handle->allocations;
-	--alloc->count;
-
-	if(
-		alloc->count == 0 &&
-		(
-			(handle->flags & ALLOC_HANDLE_FLAG_IMMEDIATE_FREE) ||
-			(
-				handle->allocators >= 2 &&
-				!(handle->flags & ALLOC_HANDLE_FLAG_DO_NOT_FREE) &&
-				handle->allocations <=
-					handle->alloc_limit * (handle->allocators - 2)
-			)
-		)
-		)
+#ifdef __linux__
+	for(alloc_t node = 0; node < ALLOC_NODE_MAX; ++node)
 	{
-		if(alloc->prev)
-		{
-			alloc->prev->next = alloc->next;
-		}
-		else
-		{
-			handle->head = (void*) alloc->next;
-		}
+		char path[64];
+		(void) snprintf(path, sizeof(path),
+			"/sys/devices/system/node/node%" PRIuPTR "/cpulist", node);
 
-		if(alloc->next)
+		FILE* file = fopen(path, "r");
+		if(!file)
 		{
-			alloc->next->prev = alloc->prev;
+			continue;
 		}
 
-		alloc_free_virtual_aligned((void*) alloc - alloc->real_ptr_off,
-			handle->block_size, handle->block_size);
+		alloc_node_count = node + 1;
 
-		--handle->allocators;
-	}
-	else
-	{
-		if(alloc->count == handle->alloc_limit - 1)
+		unsigned first;
+		while(fscanf(file, "%u", &first) == 1)
 		{
-			if(handle->head)
+			unsigned last = first;
+
+			int c = fgetc(file);
+			if(c == '-')
 			{
-				handle->head->prev = alloc;
+				if(fscanf(file, "%u", &last) != 1)
+				{
+					break;
+				}
+
+				c = fgetc(file);
 			}
 
-			assert_null(alloc->prev);
-			alloc->next = (void*) handle->head;
-			handle->head = (void*) alloc;
-		}
+			last = MACRO_MIN(last, ALLOC_CPU_MAX - 1);
 
+			for(unsigned cpu = first; cpu <= last; ++cpu)
+			{
+				alloc_cpu_nodes[cpu] = node;
+			}
 
-		(void) memcpy(ptr, &alloc->free, 2);
+			alloc_cpu_count = MACRO_MAX(alloc_cpu_count, (alloc_t) last + 1);
 
-		uint8_t* data = (uint8_t*) alloc + handle->padding;
-		alloc->free = ((void*) ptr - (void*) data) / 2;
+			if(c != ',')
+			{
+				break;
+			}
+		}
+
+		(void) fclose(file);
 	}
+#endif
 }
 
 
-private void*
-alloc_alloc_4_fn(
-	alloc_handle_impl_t* handle,
-	alloc_t size,
-	int zero
+private void
+alloc_free_node_states(
+	void
 	)
 {
-	(void) size;
-
-	alloc_4_t* alloc = (void*) handle->head;
-	if(!alloc)
+	for(alloc_t node = 0; node < ALLOC_NODE_MAX; ++node)
 	{
-		void* real_ptr = alloc_alloc_virtual_aligned(
-			handle->block_size, handle->block_size, (void**) &alloc);
-		if(!real_ptr)
+		const alloc_state* state = atomic_exchange_explicit(
+			&alloc_node_states[node], NULL, memory_order_acquire);
+		if(state)
 		{
-			return NULL;
+			alloc_free_state(state);
 		}
+	}
+}
 
-		assert_lt((void*) alloc - (void*) real_ptr, UINT32_MAX);
-		alloc->real_ptr_off = (void*) alloc - (void*) real_ptr;
-		alloc->alloc_size = handle->alloc_size;
 
-		alloc->free = ALLOC_4_MAX;
+private assert_ctor void
+alloc_library_init(
+	void
+	)
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	alloc_page_size = info.dwPageSize;
+#else
+	alloc_page_size = getpagesize();
+#endif
 
-		++handle->allocators;
-		handle->head = (void*) alloc;
-	}
+	assert_neq(alloc_page_size, 0);
+	assert_true(MACRO_IS_POWER_OF_2(alloc_page_size));
 
-	++handle->allocations;
-	++alloc->count;
+	alloc_page_size_mask = alloc_page_size - 1;
+	alloc_page_size_shift = MACRO_LOG2(alloc_page_size);
 
-	uint8_t* data = (uint8_t*) alloc + handle->padding;
+	int status = pthread_key_create(&alloc_cache_key, alloc_cache_key_fn);
+	hard_assert_eq(status, 0);
 
-	if(alloc->count == handle->alloc_limit)
-	{
-		handle->head = (void*) alloc->next;
+	status = pthread_key_create(&alloc_arena_key, alloc_arena_key_fn);
+	hard_assert_eq(status, 0);
 
-		if(alloc->next)
-		{
-			alloc->next->prev = NULL;
-		}
+	status = pthread_key_create(&alloc_pool_key, alloc_pool_key_fn);
+	hard_assert_eq(status, 0);
 
-		alloc->next = NULL;
-	}
+#ifdef ALLOC_TRACE_FILE
+	alloc_trace_init();
+#endif
 
-	if(alloc->free != ALLOC_4_MAX)
-	{
-		void* ptr = data + alloc->free * handle->alloc_size;
+	sync_mtx_init(&alloc_node_mtx);
+	alloc_read_node_topology();
 
-#ifdef ALLOC_VALGRIND
-		VALGRIND_MALLOCLIKE_BLOCK(ptr, handle->alloc_size, 0, 0);
+#ifndef ALLOC_DO_NOT_AUTO_INIT_GLOBAL_STATE
+	alloc_global_state = alloc_alloc_state(NULL);
+	assert_not_null(alloc_global_state);
 #endif
+}
 
-		(void) memcpy(&alloc->free, ptr, 4);
-
-		if(zero)
-		{
-			(void) memset(ptr, 0, handle->alloc_size);
-		}
 
-		return ptr;
-	}
+private assert_dtor void
+aloc_library_free(
+	void
+	)
+{
+	alloc_free_thread_arena();
+	alloc_flush_thread_pools();
+	alloc_flush_thread_cache();
 
-	void* ptr =  data + alloc->used++ * handle->alloc_size;
+#ifdef ALLOC_STATS_FILE
+	(void) alloc_dump_stats_s(alloc_global_state, ALLOC_STATS_FILE);
+#endif
 
-#ifdef ALLOC_VALGRIND
-	VALGRIND_MALLOCLIKE_BLOCK(ptr, handle->alloc_size, 0, 1);
+#ifdef ALLOC_TRACE_FILE
+	alloc_trace_free();
 #endif
 
-	return ptr;
+	alloc_free_node_states();
+	sync_mtx_free(&alloc_node_mtx);
+
+#ifndef ALLOC_DO_NOT_AUTO_INIT_GLOBAL_STATE
+	alloc_free_state(alloc_global_state);
+	alloc_global_state = NULL;
+#endif
 }
 
 
-private void
-alloc_free_4_fn(
-	alloc_handle_impl_t* handle,
-	void* block_ptr,
-	void* ptr,
-	alloc_t size
+_const_func_ const alloc_state*
+alloc_get_global_state(
+	void
 	)
 {
-	(void) size;
+	return alloc_global_state;
+}
 
-	alloc_4_t* alloc = block_ptr;
 
-	--handle->allocations;
-	--alloc->count;
+void
+alloc_set_node_topology(
+	alloc_t node_count,
+	_in_ uint8_t* cpu_nodes,
+	alloc_t cpu_count
+	)
+{
+	assert_gt(node_count, 0);
+	assert_le(node_count, ALLOC_NODE_MAX);
+	assert_le(cpu_count, ALLOC_CPU_MAX);
+	assert_ptr(cpu_nodes, cpu_count);
 
-	if(
-		alloc->count == 0 &&
-		(
-			(handle->flags & ALLOC_HANDLE_FLAG_IMMEDIATE_FREE) ||
-			(
-				handle->allocators >= 2 &&
-				!(handle->flags & ALLOC_HANDLE_FLAG_DO_NOT_FREE) &&
-				handle->allocations <=
-					handle->alloc_limit * (handle->allocators - 2)
-			)
-		)
-		)
+	for(alloc_t cpu = 0; cpu < cpu_count; ++cpu)
 	{
-		if(alloc->prev)
-		{
-			alloc->prev->next = alloc->next;
-		}
-		else
-		{
-			handle->head = (void*) alloc->next;
-		}
-
-		if(alloc->next)
-		{
-			alloc->next->prev = alloc->prev;
-		}
-
-		alloc_free_virtual_aligned((void*) alloc - alloc->real_ptr_off,
-			handle->block_size, handle->block_size);
-
-		--handle->allocators;
+		assert_lt(cpu_nodes[cpu], node_count);
+		alloc_cpu_nodes[cpu] = cpu_nodes[cpu];
 	}
-	else
-	{
-		if(alloc->count == handle->alloc_limit - 1)
-		{
-			if(handle->head)
-			{
-				handle->head->prev = alloc;
-			}
-
-			assert_null(alloc->prev);
-			alloc->next = (void*) handle->head;
-			handle->head = (void*) alloc;
-		}
 
+	alloc_node_count = node_count;
+	alloc_cpu_count = cpu_count;
+}
 
-		(void) memcpy(ptr, &alloc->free, 4);
 
-		uint8_t* data = (uint8_t*) alloc + handle->padding;
-		alloc->free = ((void*) ptr - (void*) data) / handle->alloc_size;
-	}
+alloc_t
+alloc_get_node_count(
+	void
+	)
+{
+	return alloc_node_count;
 }
 
 
-private void*
-alloc_alloc_virtual_fn(
-	alloc_handle_impl_t* handle,
-	alloc_t size,
-	int zero
+alloc_t
+alloc_get_current_node(
+	void
 	)
 {
-	(void) handle;
-	(void) zero;
-
-	void* ptr = alloc_alloc_virtual(size);
+	if(alloc_node_count == 1)
+	{
+		return 0;
+	}
 
-#ifdef ALLOC_VALGRIND
-	VALGRIND_MALLOCLIKE_BLOCK(ptr, size, 0, 1);
+#ifdef __linux__
+	int cpu = sched_getcpu();
+	if(cpu >= 0 && (alloc_t) cpu < alloc_cpu_count)
+	{
+		return alloc_cpu_nodes[cpu];
+	}
 #endif
 
-	return ptr;
+	return 0;
 }
 
 
-private void
-alloc_free_virtual_fn(
-	alloc_handle_impl_t* handle,
-	void* block_ptr,
-	void* ptr,
-	alloc_t size
+private const alloc_state*
+alloc_alloc_node_state(
+	alloc_t node
 	)
 {
-	(void) handle;
+	alloc_state* state = (void*) alloc_alloc_state(NULL);
+	if(!state)
+	{
+		return NULL;
+	}
 
-	assert_eq(block_ptr, ptr);
+	alloc_handle_impl_t* handle = (void*) state->handles;
+	alloc_handle_impl_t* handle_end = handle + state->handle_count;
+
+	for(; handle < handle_end; ++handle)
+	{
+		handle->page_flags |= ALLOC_PAGE_FLAG_BIND_NODE(node);
+	}
+
+	return state;
+}
+
+
+const alloc_state*
+alloc_get_node_state(
+	alloc_t node
+	)
+{
+	assert_lt(node, alloc_node_count);
+
+	if(alloc_node_count == 1)
+	{
+		return alloc_global_state;
+	}
+
+	const alloc_state* state = atomic_load_explicit(
+		&alloc_node_states[node], memory_order_acquire);
+	if(state)
+	{
+		return state;
+	}
+
+	sync_mtx_lock(&alloc_node_mtx);
+
+	state = atomic_load_explicit(&alloc_node_states[node], memory_order_relaxed);
+	if(!state)
+	{
+		state = alloc_alloc_node_state(node);
+		atomic_store_explicit(&alloc_node_states[node], state, memory_order_release);
+	}
+
+	sync_mtx_unlock(&alloc_node_mtx);
+
+	return state;
+}
+
+
+const alloc_state*
+alloc_get_local_state(
+	void
+	)
+{
+	return alloc_get_node_state(alloc_get_current_node());
+}
+
+
+void
+alloc_get_node_usage(
+	alloc_t node,
+	_out_ alloc_node_usage_t* usage
+	)
+{
+	assert_lt(node, alloc_node_count);
+	assert_not_null(usage);
+
+	*usage = (alloc_node_usage_t){0};
+
+	const alloc_state* state = alloc_node_count == 1 ? alloc_global_state :
+		atomic_load_explicit(&alloc_node_states[node], memory_order_acquire);
+	if(!state)
+	{
+		return;
+	}
+
+	for(alloc_t i = 0; i < state->handle_count; ++i)
+	{
+		alloc_handle_stats_t stats;
+		alloc_get_stats_h(&state->handles[i], &stats);
+
+		usage->objects += stats.objects;
+		usage->blocks += stats.blocks;
+		usage->bytes_in_use += stats.bytes_in_use;
+		usage->bytes_committed += stats.bytes_committed;
+	}
+}
+
+
+_const_func_ alloc_t
+alloc_get_page_size(
+	void
+	)
+{
+	return alloc_page_size;
+}
+
+
+_const_func_ alloc_t
+alloc_get_default_block_size(
+	void
+	)
+{
+	return ALLOC_DEFAULT_BLOCK_SIZE;
+}
+
+
+private void
+alloc_update_peaks(
+	alloc_handle_impl_t* handle
+	)
+{
+	alloc_t blocks = handle->allocators + handle->dirty_count + handle->clean_count;
+
+	handle->peak_allocations = MACRO_MAX(handle->peak_allocations, handle->allocations);
+	handle->peak_blocks = MACRO_MAX(handle->peak_blocks, blocks);
+}
+
+
+private void
+alloc_zero_object(
+	void* ptr,
+	alloc_t size
+	)
+{
+	if(size < ALLOC_DEFAULT_ZERO_PURGE_SIZE)
+	{
+		(void) memset(ptr, 0, size);
+		return;
+	}
+
+	uint8_t* start = ptr;
+	uint8_t* end = start + size;
+	uint8_t* page = MACRO_ALIGN_UP(start, alloc_page_size_mask);
+	uint8_t* page_end = MACRO_ALIGN_DOWN(end, alloc_page_size_mask);
+
+	if(!alloc_purge_virtual(page, page_end - page))
+	{
+		(void) memset(ptr, 0, size);
+		return;
+	}
+
+	(void) memset(start, 0, page - start);
+	(void) memset(page_end, 0, end - page_end);
+}
+
+
+private void
+alloc_link_block(
+	alloc_header_t** list,
+	alloc_header_t* block
+	)
+{
+	block->prev = NULL;
+	block->next = *list;
+
+	if(*list)
+	{
+		(*list)->prev = block;
+	}
+
+	*list = block;
+}
+
+
+private void
+alloc_unlink_block(
+	alloc_header_t** list,
+	alloc_header_t* block
+	)
+{
+	alloc_header_t* prev = block->prev;
+	alloc_header_t* next = block->next;
+
+	if(prev)
+	{
+		prev->next = next;
+	}
+	else
+	{
+		*list = next;
+	}
+
+	if(next)
+	{
+		next->prev = prev;
+	}
+
+	block->prev = NULL;
+	block->next = NULL;
+}
+
+
+private void*
+aloc_alloc_1_fn(
+	alloc_handle_impl_t* handle,
+	alloc_t size,
+	int zero
+	)
+{
+	(void) size;
+
+	alloc_1_block_t* block = (void*) handle->head;
+	if(!block)
+	{
+		void* real_ptr = alloc_alloc_virtual_aligned_flags(handle->block_size,
+			handle->block_size, handle->page_flags, (void**) &block);
+		if(!real_ptr)
+		{
+			return NULL;
+		}
+
+		/*
+		block->prev = NULL;
+		block->next = NULL;
+		*/
+		assert_lt((void*) block - (void*) real_ptr, UINT32_MAX);
+		block->real_ptr_off = (void*) block - (void*) real_ptr;
+		block->alloc_size = 1;
+		/*
+		block->count = 0;
+		block->free = 0;
+		*/
+
+		alloc_t i = 0;
+		alloc_1_t* alloc = block->allocs;
+
+		for(; i < handle->alloc_limit - 1; ++i, ++alloc)
+		{
+			alloc->next = i + 1;
+			/*
+			alloc->used = 0;
+			alloc->count = 0;
+			*/
+			alloc->free = UINT8_MAX;
+		}
+
+		alloc->next = UINT8_MAX;
+		/*
+		alloc->used = 0;
+		alloc->count = 0;
+		*/
+		alloc->free = UINT8_MAX;
+
+		++handle->allocators;
+		handle->head = (void*) block;
+	}
+
+	alloc_1_t* alloc = &block->allocs[block->free];
+
+	++handle->allocations;
+	alloc_update_peaks(handle);
+	++block->count;
+	++alloc->count;
+
+	if(alloc->count == ALLOC_1_MAX)
+	{
+		if(block->count == ALLOC_1_MAX * handle->alloc_limit)
+		{
+			alloc_unlink_block(&handle->head, (void*) block);
+			alloc_link_block(&handle->full, (void*) block);
+		}
+		else
+		{
+			block->free = alloc->next;
+		}
+	}
+
+	if(alloc->free != UINT8_MAX)
+	{
+		uint8_t* ptr = alloc->data + alloc->free;
+
+#ifdef ALLOC_VALGRIND
+		VALGRIND_MALLOCLIKE_BLOCK(ptr, 1, 0, 0);
+#endif
+
+		alloc->free = *ptr;
+
+		if(zero)
+		{
+			*ptr = 0;
+		}
+
+		return ptr;
+	}
+
+	uint8_t* ptr = alloc->data + alloc->used++;
+
+#ifdef ALLOC_VALGRIND
+	VALGRIND_MALLOCLIKE_BLOCK(ptr, 1, 0, 1);
+#endif
+
+	return ptr;
+}
+
+
+private void
+alloc_free_1_fn(
+	alloc_handle_impl_t* handle,
+	void* block_ptr,
+	void* ptr,
+	alloc_t size
+	)
+{
+	(void) size;
+
+	alloc_1_block_t* block = block_ptr;
+	alloc_1_t* alloc = &block->allocs[
+		((void*) ptr - (void*) block - sizeof(alloc_1_block_t))
+		/ sizeof(alloc_1_t)];
+
+	--handle->allocations;
+	--block->count;
+	--alloc->count;
+
+	if(block->count == ALLOC_1_MAX * handle->alloc_limit - 1)
+	{
+		alloc_unlink_block(&handle->full, (void*) block);
+		alloc_link_block(&handle->head, (void*) block);
+	}
+
+	if(
+		block->count == 0 &&
+		(
+			(handle->flags & ALLOC_HANDLE_FLAG_IMMEDIATE_FREE) ||
+			(
+				handle->allocators >= 2 &&
+				!(handle->flags & ALLOC_HANDLE_FLAG_DO_NOT_FREE) &&
+				handle->allocations <= ALLOC_1_MAX *
+					handle->alloc_limit * (handle->allocators - 2)
+			)
+		)
+		)
+	{
+		alloc_unlink_block(&handle->head, (void*) block);
+
+		alloc_free_virtual_aligned_flags((void*) block - block->real_ptr_off,
+			handle->block_size, handle->block_size, handle->page_flags);
+
+		--handle->allocators;
+	}
+	else
+	{
+		if(alloc->count == ALLOC_1_MAX - 1)
+		{
+			alloc->next = block->free;
+			block->free = alloc - block->allocs;
+		}
+
+
+		*((uint8_t*) ptr) = alloc->free;
+		alloc->free = (uint8_t*) ptr - alloc->data;
+	}
+}
+
+
+private bool
+alloc_handle_is_lazy(
+	_in_ alloc_handle_impl_t* handle
+	)
+{
+	return (handle->flags & (ALLOC_HANDLE_FLAG_IMMEDIATE_FREE |
+		ALLOC_HANDLE_FLAG_LAZY_FREE)) == ALLOC_HANDLE_FLAG_LAZY_FREE;
+}
+
+
+private void
+alloc_retain_block(
+	alloc_handle_impl_t* handle,
+	alloc_header_t* block
+	)
+{
+	block->prev = NULL;
+	block->next = handle->dirty;
+
+	handle->dirty = block;
+	++handle->dirty_count;
+}
+
+
+private alloc_header_t*
+alloc_reuse_block(
+	alloc_handle_impl_t* handle
+	)
+{
+	alloc_header_t* block = handle->dirty;
+
+	if(block)
+	{
+		handle->dirty = block->next;
+		--handle->dirty_count;
+		handle->dirty_aged = MACRO_MIN(handle->dirty_aged, handle->dirty_count);
+	}
+	else
+	{
+		block = handle->clean;
+		if(!block)
+		{
+			return NULL;
+		}
+
+		handle->clean = block->next;
+		--handle->clean_count;
+		handle->clean_aged = MACRO_MIN(handle->clean_aged, handle->clean_count);
+	}
+
+	block->next = NULL;
+
+	return block;
+}
+
+
+private alloc_header_t*
+alloc_split_aged_blocks(
+	alloc_header_t** list,
+	alloc_t count,
+	alloc_t aged
+	)
+{
+	for(alloc_t i = aged; i < count; ++i)
+	{
+		list = (alloc_header_t**) &(*list)->next;
+	}
+
+	alloc_header_t* aged_blocks = *list;
+	*list = NULL;
+
+	return aged_blocks;
+}
+
+
+private void
+alloc_unmap_block(
+	alloc_handle_impl_t* handle,
+	alloc_header_t* block
+	)
+{
+	alloc_free_virtual_aligned_flags((void*) block - block->real_ptr_off,
+		handle->block_size, handle->block_size, handle->page_flags);
+}
+
+
+private void
+alloc_unmap_blocks(
+	alloc_handle_impl_t* handle,
+	alloc_header_t* block
+	)
+{
+	while(block)
+	{
+		alloc_header_t* next = block->next;
+		alloc_unmap_block(handle, block);
+		block = next;
+	}
+}
+
+
+private bool
+alloc_purge_block(
+	alloc_handle_impl_t* handle,
+	alloc_header_t* block
+	)
+{
+	alloc_t header_size = handle->alloc_size == 2 ?
+		sizeof(alloc_2_t) : sizeof(alloc_4_t);
+
+	uint8_t* data = (uint8_t*) block + handle->padding;
+	uint8_t* page = MACRO_ALIGN_UP((uint8_t*) block + header_size, alloc_page_size_mask);
+	uint8_t* end = (uint8_t*) block + handle->block_size;
+
+	if(page < end && !alloc_purge_virtual(page, end - page))
+	{
+		return false;
+	}
+
+	if(data < page)
+	{
+		(void) memset(data, 0, MACRO_MIN(page, end) - data);
+	}
+
+	if(handle->alloc_size == 2)
+	{
+		alloc_2_t* alloc = (void*) block;
+
+		alloc->used = 0;
+		alloc->free = ALLOC_2_MAX;
+	}
+	else
+	{
+		alloc_4_t* alloc = (void*) block;
+
+		alloc->used = 0;
+		alloc->free = ALLOC_4_MAX;
+	}
+
+	return true;
+}
+
+
+private void
+alloc_reclaim_2(
+	alloc_handle_impl_t* handle
+	);
+
+
+private void*
+alloc_alloc_2_fn(
+	alloc_handle_impl_t* handle,
+	alloc_t size,
+	int zero
+	)
+{
+	(void) size;
+
+	alloc_reclaim_2(handle);
+
+	alloc_2_t* alloc = (void*) handle->head;
+	if(!alloc)
+	{
+		alloc = (void*) alloc_reuse_block(handle);
+		if(!alloc)
+		{
+			void* real_ptr = alloc_alloc_virtual_aligned_flags(handle->block_size,
+				handle->block_size, handle->page_flags, (void**) &alloc);
+			if(!real_ptr)
+			{
+				return NULL;
+			}
+
+			assert_lt((void*) alloc - (void*) real_ptr, UINT32_MAX);
+			alloc->real_ptr_off = (void*) alloc - (void*) real_ptr;
+			alloc->alloc_size = 2;
+
+			alloc->free = ALLOC_2_MAX;
+			atomic_init(alloc_2_get_remote(alloc), ALLOC_2_MAX);
+		}
+
+		++handle->allocators;
+		handle->head = (void*) alloc;
+	}
+
+	++handle->allocations;
+	alloc_update_peaks(handle);
+	++alloc->count;
+
+	uint8_t* data = (uint8_t*) alloc + handle->padding;
+
+	if(alloc->count == handle->alloc_limit)
+	{
+		alloc_unlink_block(&handle->head, (void*) alloc);
+		alloc_link_block(&handle->full, (void*) alloc);
+	}
+
+	if(alloc->free != ALLOC_2_MAX)
+	{
+		void* ptr = data + alloc->free * 2;
+
+#ifdef ALLOC_VALGRIND
+		VALGRIND_MALLOCLIKE_BLOCK(ptr, 2, 0, 0);
+#endif
+
+		(void) memcpy(&alloc->free, ptr, 2);
+
+		if(zero)
+		{
+			(void) memset(ptr, 0, 2);
+		}
+
+		return ptr;
+	}
+
+	void* ptr = data + alloc->used++ * 2;
+
+#ifdef ALLOC_VALGRIND
+	VALGRIND_MALLOCLIKE_BLOCK(ptr, 2, 0, 1);
+#endif
+
+	return ptr;
+}
+
+
+private void
+alloc_free_2_fn(
+	alloc_handle_impl_t* handle,
+	void* block_ptr,
+	void* ptr,
+	alloc_t size
+	)
+{
+	(void) size;
+
+	alloc_2_t* alloc = block_ptr;
+
+	--handle->allocations;
+	--alloc->count;
+
+	if(alloc->count == handle->alloc_limit - 1)
+	{
+		alloc_unlink_block(&handle->full, (void*) alloc);
+		alloc_link_block(&handle->head, (void*) alloc);
+	}
+
+	if(
+		alloc->count == 0 &&
+		(
+			(handle->flags & ALLOC_HANDLE_FLAG_IMMEDIATE_FREE) ||
+			(
+				handle->allocators >= 2 &&
+				!(handle->flags & ALLOC_HANDLE_FLAG_DO_NOT_FREE) &&
+				handle->allocations <=
+					handle->alloc_limit * (handle->allocators - 2)
+			)
+		)
+		)
+	{
+		alloc_unlink_block(&handle->head, (void*) alloc);
+
+		--handle->allocators;
+
+		if(alloc_handle_is_lazy(handle))
+		{
+			(void) memcpy(ptr, &alloc->free, 2);
+
+			uint8_t* data = (uint8_t*) alloc + handle->padding;
+			alloc->free = ((void*) ptr - (void*) data) / 2;
+
+			alloc_retain_block(handle, (void*) alloc);
+		}
+		else
+		{
+			alloc_unmap_block(handle, (void*) alloc);
+		}
+	}
+	else
+	{
+		(void) memcpy(ptr, &alloc->free, 2);
+
+		uint8_t* data = (uint8_t*) alloc + handle->padding;
+		alloc->free = ((void*) ptr - (void*) data) / 2;
+	}
+}
+
+
+private void
+alloc_remote_2_fn(
+	alloc_handle_impl_t* handle,
+	void* block_ptr,
+	void* ptr
+	)
+{
+	alloc_2_t* alloc = block_ptr;
+	_Atomic uint16_t* remote = alloc_2_get_remote(alloc);
+
+	uint8_t* data = (uint8_t*) alloc + handle->padding;
+	uint16_t idx = ((void*) ptr - (void*) data) / 2;
+
+	uint16_t head = atomic_load_explicit(remote, memory_order_relaxed);
+
+	do
+	{
+		(void) memcpy(ptr, &head, 2);
+	}
+	while(!atomic_compare_exchange_weak_explicit(remote, &head, idx,
+		memory_order_release, memory_order_relaxed));
+
+	if(head != ALLOC_2_MAX)
+	{
+		return;
+	}
+
+	void* next = atomic_load_explicit(&handle->remote, memory_order_relaxed);
+
+	do
+	{
+		alloc->remote_next = next;
+	}
+	while(!atomic_compare_exchange_weak_explicit(&handle->remote, &next, alloc,
+		memory_order_release, memory_order_relaxed));
+}
+
+
+private void
+alloc_reclaim_2(
+	alloc_handle_impl_t* handle
+	)
+{
+	if(!atomic_load_explicit(&handle->remote, memory_order_relaxed))
+	{
+		return;
+	}
+
+	alloc_2_t* alloc = atomic_exchange_explicit(
+		&handle->remote, NULL, memory_order_acquire);
+
+	while(alloc)
+	{
+		alloc_2_t* next = alloc->remote_next;
+
+		uint16_t idx = atomic_exchange_explicit(alloc_2_get_remote(alloc),
+			ALLOC_2_MAX, memory_order_acquire);
+		uint8_t* data = (uint8_t*) alloc + handle->padding;
+
+		while(idx != ALLOC_2_MAX)
+		{
+			void* ptr = data + idx * 2;
+			(void) memcpy(&idx, ptr, 2);
+
+			alloc_free_2_fn(handle, alloc, ptr, 2);
+		}
+
+		alloc = next;
+	}
+}
+
+
+private void
+alloc_reclaim_4(
+	alloc_handle_impl_t* handle
+	);
+
+
+private void*
+alloc_alloc_4_fn(
+	alloc_handle_impl_t* handle,
+	alloc_t size,
+	int zero
+	)
+{
+	(void) size;
+
+	alloc_reclaim_4(handle);
+
+	alloc_4_t* alloc = (void*) handle->head;
+	if(!alloc)
+	{
+		alloc = (void*) alloc_reuse_block(handle);
+		if(!alloc)
+		{
+			void* real_ptr = alloc_alloc_virtual_aligned_flags(handle->block_size,
+				handle->block_size, handle->page_flags, (void**) &alloc);
+			if(!real_ptr)
+			{
+				return NULL;
+			}
+
+			assert_lt((void*) alloc - (void*) real_ptr, UINT32_MAX);
+			alloc->real_ptr_off = (void*) alloc - (void*) real_ptr;
+			alloc->alloc_size = handle->alloc_size;
+
+			alloc->free = ALLOC_4_MAX;
+			atomic_init(alloc_4_get_remote(alloc), ALLOC_4_MAX);
+		}
+
+		++handle->allocators;
+		handle->head = (void*) alloc;
+	}
+
+	++handle->allocations;
+	alloc_update_peaks(handle);
+	++alloc->count;
+
+	uint8_t* data = (uint8_t*) alloc + handle->padding;
+
+	if(alloc->count == handle->alloc_limit)
+	{
+		alloc_unlink_block(&handle->head, (void*) alloc);
+		alloc_link_block(&handle->full, (void*) alloc);
+	}
+
+	if(alloc->free != ALLOC_4_MAX)
+	{
+		void* ptr = data + alloc->free * handle->alloc_size;
+
+#ifdef ALLOC_VALGRIND
+		VALGRIND_MALLOCLIKE_BLOCK(ptr, handle->alloc_size, 0, 0);
+#endif
+
+		(void) memcpy(&alloc->free, ptr, 4);
+
+		if(zero)
+		{
+			alloc_zero_object(ptr, size);
+		}
+
+		return ptr;
+	}
+
+	void* ptr =  data + alloc->used++ * handle->alloc_size;
+
+#ifdef ALLOC_VALGRIND
+	VALGRIND_MALLOCLIKE_BLOCK(ptr, handle->alloc_size, 0, 1);
+#endif
+
+	return ptr;
+}
+
+
+private void
+alloc_free_4_fn(
+	alloc_handle_impl_t* handle,
+	void* block_ptr,
+	void* ptr,
+	alloc_t size
+	)
+{
+	(void) size;
+
+	alloc_4_t* alloc = block_ptr;
+
+	--handle->allocations;
+	--alloc->count;
+
+	if(alloc->count == handle->alloc_limit - 1)
+	{
+		alloc_unlink_block(&handle->full, (void*) alloc);
+		alloc_link_block(&handle->head, (void*) alloc);
+	}
+
+	if(
+		alloc->count == 0 &&
+		(
+			(handle->flags & ALLOC_HANDLE_FLAG_IMMEDIATE_FREE) ||
+			(
+				handle->allocators >= 2 &&
+				!(handle->flags & ALLOC_HANDLE_FLAG_DO_NOT_FREE) &&
+				handle->allocations <=
+					handle->alloc_limit * (handle->allocators - 2)
+			)
+		)
+		)
+	{
+		alloc_unlink_block(&handle->head, (void*) alloc);
+
+		--handle->allocators;
+
+		if(alloc_handle_is_lazy(handle))
+		{
+			(void) memcpy(ptr, &alloc->free, 4);
+
+			uint8_t* data = (uint8_t*) alloc + handle->padding;
+			alloc->free = ((void*) ptr - (void*) data) / handle->alloc_size;
+
+			alloc_retain_block(handle, (void*) alloc);
+		}
+		else
+		{
+			alloc_unmap_block(handle, (void*) alloc);
+		}
+	}
+	else
+	{
+		(void) memcpy(ptr, &alloc->free, 4);
+
+		uint8_t* data = (uint8_t*) alloc + handle->padding;
+		alloc->free = ((void*) ptr - (void*) data) / handle->alloc_size;
+	}
+}
+
+
+private void
+alloc_remote_4_fn(
+	alloc_handle_impl_t* handle,
+	void* block_ptr,
+	void* ptr
+	)
+{
+	alloc_4_t* alloc = block_ptr;
+	_Atomic uint32_t* remote = alloc_4_get_remote(alloc);
+
+	uint8_t* data = (uint8_t*) alloc + handle->padding;
+	uint32_t idx = ((void*) ptr - (void*) data) / handle->alloc_size;
+
+	uint32_t head = atomic_load_explicit(remote, memory_order_relaxed);
+
+	do
+	{
+		(void) memcpy(ptr, &head, 4);
+	}
+	while(!atomic_compare_exchange_weak_explicit(remote, &head, idx,
+		memory_order_release, memory_order_relaxed));
+
+	if(head != ALLOC_4_MAX)
+	{
+		return;
+	}
+
+	void* next = atomic_load_explicit(&handle->remote, memory_order_relaxed);
+
+	do
+	{
+		alloc->remote_next = next;
+	}
+	while(!atomic_compare_exchange_weak_explicit(&handle->remote, &next, alloc,
+		memory_order_release, memory_order_relaxed));
+}
+
+
+private void
+alloc_reclaim_4(
+	alloc_handle_impl_t* handle
+	)
+{
+	if(!atomic_load_explicit(&handle->remote, memory_order_relaxed))
+	{
+		return;
+	}
+
+	alloc_4_t* alloc = atomic_exchange_explicit(
+		&handle->remote, NULL, memory_order_acquire);
+
+	while(alloc)
+	{
+		alloc_4_t* next = alloc->remote_next;
+
+		uint32_t idx = atomic_exchange_explicit(alloc_4_get_remote(alloc),
+			ALLOC_4_MAX, memory_order_acquire);
+		uint8_t* data = (uint8_t*) alloc + handle->padding;
+
+		while(idx != ALLOC_4_MAX)
+		{
+			void* ptr = data + idx * handle->alloc_size;
+			(void) memcpy(&idx, ptr, 4);
+
+			alloc_free_4_fn(handle, alloc, ptr, handle->alloc_size);
+		}
+
+		alloc = next;
+	}
+}
+
+
+private void
+alloc_add_virtual_bytes(
+	alloc_handle_impl_t* handle,
+	alloc_t bytes
+	)
+{
+	alloc_t total = atomic_fetch_add_explicit(&handle->virtual_bytes,
+		bytes, memory_order_relaxed) + bytes;
+
+	alloc_t peak = atomic_load_explicit(
+		&handle->peak_virtual_bytes, memory_order_relaxed);
+
+	while(
+		peak < total &&
+		!atomic_compare_exchange_weak_explicit(&handle->peak_virtual_bytes,
+			&peak, total, memory_order_relaxed, memory_order_relaxed)
+		);
+}
+
+
+private void*
+alloc_alloc_virtual_fn(
+	alloc_handle_impl_t* handle,
+	alloc_t size,
+	int zero
+	)
+{
+	(void) zero;
+
+	void* ptr = alloc_alloc_virtual_flags(size,
+		handle->page_flags & ALLOC_PAGE_FLAG_NODE_MASK);
+	if(!ptr)
+	{
+		return NULL;
+	}
+
+	++handle->allocations;
+	alloc_update_peaks(handle);
+
+	alloc_add_virtual_bytes(handle, MACRO_ALIGN_UP(size, alloc_page_size_mask));
+
+#ifdef ALLOC_VALGRIND
+	VALGRIND_MALLOCLIKE_BLOCK(ptr, size, 0, 1);
+#endif
+
+	return ptr;
+}
+
+
+private void
+alloc_free_virtual_fn(
+	alloc_handle_impl_t* handle,
+	void* block_ptr,
+	void* ptr,
+	alloc_t size
+	)
+{
+	assert_eq(block_ptr, ptr);
 
 	alloc_free_virtual(ptr, size);
+
+	--handle->allocations;
+
+	atomic_fetch_sub_explicit(&handle->virtual_bytes,
+		MACRO_ALIGN_UP(size, alloc_page_size_mask), memory_order_relaxed);
+}
+
+
+private void*
+alloc_realloc_virtual_fn(
+	alloc_handle_impl_t* handle,
+	_opaque_ void* ptr,
+	alloc_t old_size,
+	alloc_t new_size
+	)
+{
+	alloc_trace(ALLOC_TRACE_OP_REALLOC, ptr, old_size);
+
+	void* new_ptr = alloc_realloc_virtual(ptr, old_size, new_size);
+	if(!new_ptr)
+	{
+		alloc_trace(ALLOC_TRACE_OP_REALLOC_FAIL, ptr, old_size);
+		return NULL;
+	}
+
+	alloc_trace(ALLOC_TRACE_OP_ALLOC, new_ptr, new_size);
+
+	alloc_add_virtual_bytes(handle,
+		MACRO_ALIGN_UP(new_size, alloc_page_size_mask) -
+		MACRO_ALIGN_UP(old_size, alloc_page_size_mask));
+
+	return new_ptr;
+}
+
+
+private int
+alloc_handle_is_virtual(
+	_in_ alloc_handle_impl_t* handle
+	)
+{
+	return !handle->block_size;
+}
+
+
+private alloc_t
+alloc_get_ptr_mask(
+	_in_ alloc_handle_impl_t* handle,
+	alloc_t size
+	)
+{
+	if(alloc_handle_is_virtual(handle))
+	{
+		return alloc_page_size_mask;
+	}
+
+	alloc_t class_mask = (handle->alloc_size & -handle->alloc_size) - 1;
+
+	return MACRO_MIN(MACRO_POWER_OF_2_MASK(size), class_mask);
+}
+
+
+void
+alloc_create_handle(
+	_in_ alloc_handle_info_t* info,
+	_opaque_ alloc_handle_t* handle
+	)
+{
+	alloc_handle_impl_t* handle_impl = (void*) handle;
+
+	sync_mtx_init(&handle_impl->mtx);
+
+	handle_impl->allocators = 0;
+	handle_impl->allocations = 0;
+
+	handle_impl->head = NULL;
+	handle_impl->full = NULL;
+
+	handle_impl->dirty = NULL;
+	handle_impl->clean = NULL;
+	handle_impl->dirty_count = 0;
+	handle_impl->dirty_aged = 0;
+	handle_impl->clean_count = 0;
+	handle_impl->clean_aged = 0;
+
+	handle_impl->flags = info ? info->flags : ALLOC_HANDLE_FLAG_NONE;
+	handle_impl->page_flags = info ? info->page_flags : ALLOC_PAGE_FLAG_NONE;
+
+	handle_impl->remote_fn = NULL;
+	atomic_init(&handle_impl->remote, NULL);
+
+	handle_impl->peak_allocations = 0;
+	handle_impl->peak_blocks = 0;
+	handle_impl->locks = 0;
+	handle_impl->contended_locks = 0;
+	atomic_init(&handle_impl->virtual_bytes, 0);
+	atomic_init(&handle_impl->peak_virtual_bytes, 0);
+
+
+	if(!info)
+	{
+		handle_impl->padding = 0;
+		handle_impl->alloc_limit = 0;
+		handle_impl->alloc_size = 0;
+		handle_impl->block_size = 0;
+
+		handle_impl->alloc_fn = alloc_alloc_virtual_fn;
+		handle_impl->free_fn = alloc_free_virtual_fn;
+
+		return;
+	}
+
+
+	assert_neq(info->alignment, 0);
+	assert_eq(MACRO_IS_POWER_OF_2(info->alignment), 1);
+
+
+	static const alloc_t block_size_max[] =
+	(const alloc_t[])
+	{
+		0,
+		65536,
+		131072,
+		1073741824
+	};
+
+	static const alloc_t alloc_limit_max[] =
+	(const alloc_t[])
+	{
+		0,
+		UINT8_MAX - 2,
+		UINT16_MAX - 2,
+		UINT32_MAX - 2
+	};
+
+	static const alloc_alloc_fn_t alloc_fns[] =
+	(const alloc_alloc_fn_t[])
+	{
+		NULL,
+		aloc_alloc_1_fn,
+		alloc_alloc_2_fn,
+		alloc_alloc_4_fn
+	};
+
+	static const alloc_free_fn_t free_fns[] =
+	(const alloc_free_fn_t[])
+	{
+		NULL,
+		alloc_free_1_fn,
+		alloc_free_2_fn,
+		alloc_free_4_fn
+	};
+
+	static const alloc_remote_fn_t remote_fns[] =
+	(const alloc_remote_fn_t[])
+	{
+		NULL,
+		NULL,
+		alloc_remote_2_fn,
+		alloc_remote_4_fn
+	};
+
+	alloc_t table_idx = MACRO_MIN(info->alloc_size, 3U);
+
+
+	if(info->alloc_size == 1)
+	{
+		alloc_t block_size = info->block_size;
+		block_size = MACRO_MIN(block_size, block_size_max[table_idx]);
+		block_size = MACRO_MAX(block_size, alloc_page_size);
+		block_size = MACRO_NEXT_OR_EQUAL_POWER_OF_2(block_size);
+
+		alloc_t alloc_limit =
+			(block_size - sizeof(alloc_1_block_t)) / sizeof(alloc_1_t);
+		alloc_limit = MACRO_MIN(alloc_limit, alloc_limit_max[table_idx]);
+		alloc_limit = MACRO_MAX(alloc_limit, 1U);
+
+		block_size = sizeof(alloc_1_block_t) + alloc_limit * sizeof(alloc_1_t);
+		block_size = MACRO_NEXT_OR_EQUAL_POWER_OF_2(block_size);
+
+		handle_impl->padding = 0;
+		handle_impl->alloc_limit = alloc_limit;
+		handle_impl->alloc_size = 1;
+		handle_impl->block_size = block_size;
+
+		handle_impl->alloc_fn = alloc_fns[table_idx];
+		handle_impl->free_fn = free_fns[table_idx];
+
+		return;
+	}
+
+
+	alloc_t alloc_size = info->alloc_size == 2 ? sizeof(alloc_2_t) : sizeof(alloc_4_t);
+
+	alloc_t mask = info->alignment - 1;
+	alloc_t padding = (alloc_size + mask) & ~mask;
+
+	alloc_t block_size = info->block_size;
+	block_size = MACRO_MIN(block_size, block_size_max[table_idx]);
+	block_size = MACRO_MAX(block_size, alloc_page_size);
+	block_size = MACRO_NEXT_OR_EQUAL_POWER_OF_2(block_size);
+
+	alloc_t alloc_limit = (block_size - alloc_size) / info->alloc_size;
+	alloc_limit = MACRO_MIN(alloc_limit, alloc_limit_max[table_idx]);
+	alloc_limit = MACRO_MAX(alloc_limit, 1U);
+
+	block_size = padding + alloc_limit * info->alloc_size;
+	block_size = MACRO_NEXT_OR_EQUAL_POWER_OF_2(block_size);
+
+	handle_impl->padding = padding;
+	handle_impl->alloc_limit = alloc_limit;
+	handle_impl->alloc_size = info->alloc_size;
+	handle_impl->block_size = info->block_size;
+
+	handle_impl->alloc_fn = alloc_fns[table_idx];
+	handle_impl->free_fn = free_fns[table_idx];
+	handle_impl->remote_fn = remote_fns[table_idx];
+}
+
+
+void
+alloc_clone_handle(
+	_opaque_ alloc_handle_t* source,
+	_opaque_ alloc_handle_t* handle
+	)
+{
+	alloc_handle_impl_t* source_impl = (void*) source;
+
+	alloc_handle_info_t info =
+	{
+		.alloc_size = source_impl->alloc_size,
+		.block_size = source_impl->block_size,
+		.alignment = source_impl->padding,
+		.page_flags = source_impl->page_flags
+	};
+
+	alloc_create_handle(&info, handle);
+}
+
+
+void
+alloc_free_handle(
+	_opaque_ alloc_handle_t* handle
+	)
+{
+	alloc_handle_impl_t* handle_impl = (void*) handle;
+
+	alloc_unmap_blocks(handle_impl, handle_impl->head);
+	alloc_unmap_blocks(handle_impl, handle_impl->full);
+	alloc_unmap_blocks(handle_impl, handle_impl->dirty);
+	alloc_unmap_blocks(handle_impl, handle_impl->clean);
+
+
+	sync_mtx_free(&handle_impl->mtx);
+}
+
+
+private uint32_t
+alloc_get_class_idx(
+	uint32_t class_shift,
+	alloc_t size
+	)
+{
+	if(size <= 1)
+	{
+		return 0;
+	}
+
+	alloc_t last = size - 1;
+	uint32_t shift = 63 - __builtin_clzll(last);
+
+	if(shift < ALLOC_STEPPED_CLASS_SHIFT)
+	{
+		return shift + 1;
+	}
+
+	alloc_t step = (last >> (shift - class_shift)) & ((1U << class_shift) - 1);
+
+	return ALLOC_STEPPED_CLASS_SHIFT +
+		((shift - ALLOC_STEPPED_CLASS_SHIFT) << class_shift) + step + 1;
+}
+
+
+private alloc_t
+alloc_generate_handle_info(
+	uint32_t class_steps,
+	alloc_handle_info_t* handles
+	)
+{
+	alloc_handle_info_t* handle = handles;
+
+	*(handle++) = alloc_default_handle_info[0];
+
+	for(uint32_t shift = 1; shift < ALLOC_STEPPED_CLASS_SHIFT; ++shift)
+	{
+		*(handle++) =
+		(alloc_handle_info_t)
+		{
+			.alloc_size = MACRO_POWER_OF_2(shift),
+			.block_size = ALLOC_DEFAULT_BLOCK_SIZE,
+			.alignment = MACRO_POWER_OF_2(shift)
+		};
+	}
+
+	for(uint32_t shift = ALLOC_STEPPED_CLASS_SHIFT; ; ++shift)
+	{
+		alloc_t base = MACRO_POWER_OF_2(shift);
+		alloc_t step = base / class_steps;
+
+		for(uint32_t i = 0; i < class_steps; ++i)
+		{
+			alloc_t alloc_size = base + step * i;
+
+			if(alloc_size > (ALLOC_DEFAULT_BLOCK_SIZE >> 1))
+			{
+				return handle - handles;
+			}
+
+			*(handle++) =
+			(alloc_handle_info_t)
+			{
+				.alloc_size = alloc_size,
+				.block_size = ALLOC_DEFAULT_BLOCK_SIZE,
+				.alignment = alloc_size & -alloc_size
+			};
+		}
+	}
+}
+
+
+_alloc_func_ const alloc_state*
+alloc_alloc_state(
+	_in_ alloc_state_info_t* info
+	)
+{
+	if(!info)
+	{
+		info = &alloc_default_state_info;
+	}
+
+
+	uint32_t class_steps = MACRO_MAX(info->class_steps, 1U);
+	assert_le(class_steps, ALLOC_CLASS_STEPS_MAX);
+	assert_true(MACRO_IS_POWER_OF_2(class_steps));
+
+	alloc_handle_info_t handle_infos[ALLOC_CLASS_COUNT_MAX];
+	alloc_handle_info_t* handle_info = info->handles;
+	alloc_t info_count = info->handle_count;
+
+	if(!handle_info)
+	{
+		if(class_steps == 1)
+		{
+			handle_info = alloc_default_handle_info;
+			info_count = MACRO_ARRAY_LEN(alloc_default_handle_info);
+		}
+		else
+		{
+			handle_info = handle_infos;
+			info_count = alloc_generate_handle_info(class_steps, handle_infos);
+		}
+	}
+
+
+	alloc_t handle_count = info_count + 1;
+	alloc_state* state = alloc_alloc_virtual(
+		sizeof(alloc_state) + sizeof(alloc_handle_t) * handle_count);
+	if(!state)
+	{
+		return NULL;
+	}
+
+	state->idx_fn = info->idx_fn;
+	state->class_shift = MACRO_LOG2(class_steps);
+
+	if(!state->idx_fn)
+	{
+		assert_le(handle_count, UINT8_MAX + 1);
+
+		for(alloc_t size = 0; size < ALLOC_IDX_TABLE_SIZE; ++size)
+		{
+			uint32_t idx = alloc_get_class_idx(state->class_shift, size);
+			state->idx_table[size] = MACRO_MIN(idx, handle_count - 1);
+		}
+	}
+
+	state->handle_count = handle_count;
+
+
+	alloc_handle_info_t* handle_info_end = handle_info + info_count;
+
+	alloc_handle_t* handle = state->handles;
+
+	for(; handle_info < handle_info_end; ++handle_info, ++handle)
+	{
+		alloc_handle_info_t state_handle_info = *handle_info;
+		state_handle_info.flags |= info->flags;
+
+		alloc_page_flag_t page_flags = info->page_flags;
+		if(state_handle_info.block_size < ALLOC_HUGE_PAGE_SIZE)
+		{
+			page_flags &= ~ALLOC_PAGE_FLAG_HUGE;
+		}
+
+		state_handle_info.page_flags |= page_flags;
+
+		alloc_create_handle(&state_handle_info, handle);
+	}
+
+	alloc_create_handle(NULL, handle);
+
+
+	return state;
+}
+
+
+_alloc_func_ const alloc_state*
+alloc_clone_state(
+	_in_ alloc_state* source
+	)
+{
+	alloc_t handle_count = source->handle_count;
+	alloc_t total_size = sizeof(alloc_state) + sizeof(alloc_handle_t) * handle_count;
+
+	alloc_state* state = alloc_alloc_virtual(total_size);
+	if(!state)
+	{
+		return NULL;
+	}
+
+	(void) memcpy(state, source, total_size);
+
+	alloc_handle_impl_t* handle = (void*) state->handles;
+	alloc_handle_impl_t* handle_end = handle + handle_count;
+
+	for(; handle < handle_end; ++handle)
+	{
+		sync_mtx_init(&handle->mtx);
+
+		handle->allocators = 0;
+		handle->allocations = 0;
+
+		handle->flags = 0;
+
+		handle->head = NULL;
+		handle->full = NULL;
+
+		handle->dirty = NULL;
+		handle->clean = NULL;
+		handle->dirty_count = 0;
+		handle->dirty_aged = 0;
+		handle->clean_count = 0;
+		handle->clean_aged = 0;
+
+		atomic_init(&handle->remote, NULL);
+
+		handle->peak_allocations = 0;
+		handle->peak_blocks = 0;
+		handle->locks = 0;
+		handle->contended_locks = 0;
+		atomic_init(&handle->virtual_bytes, 0);
+		atomic_init(&handle->peak_virtual_bytes, 0);
+	}
+
+	return state;
+}
+
+
+void
+alloc_free_state(
+	_opaque_ alloc_state* state
+	)
+{
+	if(!state)
+	{
+		state = alloc_global_state;
+	}
+
+
+	alloc_t i = 0;
+	alloc_t handle_count = state->handle_count;
+
+	for(; i < handle_count; ++i)
+	{
+		alloc_free_handle(&state->handles[i]);
+	}
+
+	alloc_free_virtual(state, sizeof(alloc_state) +
+		handle_count * sizeof(alloc_handle_impl_t));
+}
+
+
+_pure_func_ _opaque_ alloc_handle_t*
+alloc_get_handle_s(
+	_in_ alloc_state* state,
+	alloc_t size
+	)
+{
+	if(size == 0)
+	{
+		return NULL;
+	}
+
+	uint32_t idx;
+
+	if(state->idx_fn)
+	{
+		idx = state->idx_fn(size);
+	}
+	else if(size < ALLOC_IDX_TABLE_SIZE)
+	{
+		idx = state->idx_table[size];
+	}
+	else
+	{
+		idx = alloc_get_class_idx(state->class_shift, size);
+	}
+
+	idx = MACRO_MIN(idx, state->handle_count - 1);
+
+	return &state->handles[idx];
+}
+
+
+void
+alloc_handle_lock_h(
+	_opaque_ alloc_handle_t* handle
+	)
+{
+	alloc_handle_impl_t* handle_impl = (void*) handle;
+
+	if(!sync_mtx_try_lock(&handle_impl->mtx))
+	{
+		sync_mtx_lock(&handle_impl->mtx);
+		++handle_impl->contended_locks;
+	}
+
+	++handle_impl->locks;
+}
+
+
+void
+alloc_handle_unlock_h(
+	_opaque_ alloc_handle_t* handle
+	)
+{
+	alloc_handle_impl_t* handle_impl = (void*) handle;
+
+	sync_mtx_unlock(&handle_impl->mtx);
+}
+
+
+private bool
+alloc_handle_try_lock(
+	alloc_handle_impl_t* handle
+	)
+{
+	if(!sync_mtx_try_lock(&handle->mtx))
+	{
+		return false;
+	}
+
+	++handle->locks;
+
+	return true;
+}
+
+
+void
+alloc_handle_set_flags_h(
+	_opaque_ alloc_handle_t* handle,
+	alloc_handle_flag_t flags
+	)
+{
+	alloc_handle_lock_h(handle);
+		alloc_handle_set_flags_uh(handle, flags);
+	alloc_handle_unlock_h(handle);
+}
+
+
+void
+alloc_handle_set_flags_uh(
+	_opaque_ alloc_handle_t* handle,
+	alloc_handle_flag_t flags
+	)
+{
+	alloc_handle_impl_t* handle_impl = (void*) handle;
+
+	handle_impl->flags = flags;
+}
+
+
+void
+alloc_handle_add_flags_h(
+	_opaque_ alloc_handle_t* handle,
+	alloc_handle_flag_t flags
+	)
+{
+	alloc_handle_lock_h(handle);
+		alloc_handle_add_flags_uh(handle, flags);
+	alloc_handle_unlock_h(handle);
+}
+
+
+void
+alloc_handle_add_flags_uh(
+	_opaque_ alloc_handle_t* handle,
+	alloc_handle_flag_t flags
+	)
+{
+	alloc_handle_impl_t* handle_impl = (void*) handle;
+
+	handle_impl->flags |= flags;
+}
+
+
+void
+alloc_handle_del_flags_h(
+	_opaque_ alloc_handle_t* handle,
+	alloc_handle_flag_t flags
+	)
+{
+	alloc_handle_lock_h(handle);
+		alloc_handle_del_flags_uh(handle, flags);
+	alloc_handle_unlock_h(handle);
+}
+
+
+void
+alloc_handle_del_flags_uh(
+	_opaque_ alloc_handle_t* handle,
+	alloc_handle_flag_t flags
+	)
+{
+	alloc_handle_impl_t* handle_impl = (void*) handle;
+
+	handle_impl->flags &= ~flags;
+}
+
+
+alloc_handle_flag_t
+alloc_handle_get_flags_h(
+	_opaque_ alloc_handle_t* handle
+	)
+{
+	alloc_handle_flag_t flags;
+
+	alloc_handle_lock_h(handle);
+		flags = alloc_handle_get_flags_uh(handle);
+	alloc_handle_unlock_h(handle);
+
+	return flags;
+}
+
+
+alloc_handle_flag_t
+alloc_handle_get_flags_uh(
+	_opaque_ alloc_handle_t* handle
+	)
+{
+	alloc_handle_impl_t* handle_impl = (void*) handle;
+
+	return handle_impl->flags;
+}
+
+
+void
+alloc_purge_h(
+	_opaque_ alloc_handle_t* handle
+	)
+{
+	alloc_handle_lock_h(handle);
+		alloc_purge_uh(handle);
+	alloc_handle_unlock_h(handle);
+}
+
+
+void
+alloc_purge_uh(
+	_opaque_ alloc_handle_t* handle
+	)
+{
+	alloc_handle_impl_t* handle_impl = (void*) handle;
+
+	if(handle_impl->remote_fn)
+	{
+		if(handle_impl->alloc_size == 2)
+		{
+			alloc_reclaim_2(handle_impl);
+		}
+		else
+		{
+			alloc_reclaim_4(handle_impl);
+		}
+	}
+
+	alloc_header_t* block = alloc_split_aged_blocks(&handle_impl->clean,
+		handle_impl->clean_count, handle_impl->clean_aged);
+	handle_impl->clean_count -= handle_impl->clean_aged;
+
+	alloc_unmap_blocks(handle_impl, block);
+
+	block = alloc_split_aged_blocks(&handle_impl->dirty,
+		handle_impl->dirty_count, handle_impl->dirty_aged);
+	handle_impl->dirty_count -= handle_impl->dirty_aged;
+
+	while(block)
+	{
+		alloc_header_t* next = block->next;
+
+		if(alloc_purge_block(handle_impl, block))
+		{
+			block->next = handle_impl->clean;
+			handle_impl->clean = block;
+			++handle_impl->clean_count;
+		}
+		else
+		{
+			alloc_unmap_block(handle_impl, block);
+		}
+
+		block = next;
+	}
+
+	handle_impl->dirty_aged = handle_impl->dirty_count;
+	handle_impl->clean_aged = handle_impl->clean_count;
+}
+
+
+void
+alloc_purge_s(
+	_opaque_ alloc_state* state
+	)
+{
+	if(!state)
+	{
+		state = alloc_global_state;
+	}
+
+	alloc_handle_t* handle = (void*) state->handles;
+	alloc_handle_t* handle_end = handle + state->handle_count;
+
+	for(; handle < handle_end; ++handle)
+	{
+		alloc_purge_h(handle);
+	}
+}
+
+
+void
+alloc_get_stats_h(
+	_opaque_ alloc_handle_t* handle,
+	_out_ alloc_handle_stats_t* stats
+	)
+{
+	alloc_handle_lock_h(handle);
+		alloc_get_stats_uh(handle, stats);
+	alloc_handle_unlock_h(handle);
+}
+
+
+void
+alloc_get_stats_uh(
+	_opaque_ alloc_handle_t* handle,
+	_out_ alloc_handle_stats_t* stats
+	)
+{
+	assert_not_null(stats);
+
+	alloc_handle_impl_t* handle_impl = (void*) handle;
+
+	stats->alloc_size = handle_impl->alloc_size;
+	stats->block_size = handle_impl->block_size;
+
+	stats->objects = handle_impl->allocations;
+	stats->peak_objects = handle_impl->peak_allocations;
+
+	stats->retained_blocks = handle_impl->dirty_count + handle_impl->clean_count;
+	stats->blocks = handle_impl->allocators + stats->retained_blocks;
+	stats->peak_blocks = handle_impl->peak_blocks;
+
+	if(alloc_handle_is_virtual(handle_impl))
+	{
+		alloc_t bytes = atomic_load_explicit(
+			&handle_impl->virtual_bytes, memory_order_relaxed);
+
+		stats->bytes_in_use = bytes;
+		stats->bytes_committed = bytes;
+		stats->peak_bytes_committed = atomic_load_explicit(
+			&handle_impl->peak_virtual_bytes, memory_order_relaxed);
+	}
+	else
+	{
+		stats->bytes_in_use = handle_impl->allocations * handle_impl->alloc_size;
+		stats->bytes_committed = (handle_impl->allocators +
+			handle_impl->dirty_count) * handle_impl->block_size;
+		stats->peak_bytes_committed = handle_impl->peak_blocks * handle_impl->block_size;
+	}
+
+	stats->locks = handle_impl->locks;
+	stats->contended_locks = handle_impl->contended_locks;
+}
+
+
+void
+alloc_get_stats_s(
+	_opaque_ alloc_state* state,
+	_out_ alloc_handle_stats_t* stats
+	)
+{
+	if(!state)
+	{
+		state = alloc_global_state;
+	}
+
+	assert_not_null(stats);
+
+	for(alloc_t i = 0; i < state->handle_count; ++i)
+	{
+		alloc_get_stats_h(&state->handles[i], &stats[i]);
+	}
+}
+
+
+bool
+alloc_dump_stats_s(
+	_opaque_ alloc_state* state,
+	const char* path
+	)
+{
+	if(!state)
+	{
+		state = alloc_global_state;
+	}
+
+	assert_not_null(path);
+
+	FILE* file = fopen(path, "w");
+	if(!file)
+	{
+		return false;
+	}
+
+	(void) fprintf(file,
+		"%12s %10s %10s %10s %8s %8s %8s %14s %14s %14s %6s %12s %10s\n",
+		"alloc_size", "block_size", "objects", "peak", "blocks", "peak",
+		"retained", "in_use", "committed", "peak_committed", "used%",
+		"locks", "contended"
+		);
+
+	alloc_handle_stats_t total = {0};
+
+	for(alloc_t i = 0; i < state->handle_count; ++i)
+	{
+		alloc_handle_stats_t stats;
+		alloc_get_stats_h(&state->handles[i], &stats);
+
+		alloc_t used = stats.bytes_committed ?
+			stats.bytes_in_use * 100 / stats.bytes_committed : 100;
+
+		(void) fprintf(file,
+			"%12" PRIuPTR " %10" PRIuPTR " %10" PRIuPTR " %10" PRIuPTR
+			" %8" PRIuPTR " %8" PRIuPTR " %8" PRIuPTR " %14" PRIuPTR
+			" %14" PRIuPTR " %14" PRIuPTR " %6" PRIuPTR " %12" PRIuPTR
+			" %10" PRIuPTR "\n",
+			stats.alloc_size, stats.block_size, stats.objects,
+			stats.peak_objects, stats.blocks, stats.peak_blocks,
+			stats.retained_blocks, stats.bytes_in_use, stats.bytes_committed,
+			stats.peak_bytes_committed, used, stats.locks, stats.contended_locks
+			);
+
+		total.objects += stats.objects;
+		total.blocks += stats.blocks;
+		total.retained_blocks += stats.retained_blocks;
+		total.bytes_in_use += stats.bytes_in_use;
+		total.bytes_committed += stats.bytes_committed;
+		total.locks += stats.locks;
+		total.contended_locks += stats.contended_locks;
+	}
+
+	(void) fprintf(file,
+		"%12s %10s %10" PRIuPTR " %10s %8" PRIuPTR " %8s %8" PRIuPTR
+		" %14" PRIuPTR " %14" PRIuPTR " %14s %6s %12" PRIuPTR " %10" PRIuPTR "\n",
+		"total", "", total.objects, "", total.blocks, "", total.retained_blocks,
+		total.bytes_in_use, total.bytes_committed, "", "", total.locks,
+		total.contended_locks
+		);
+
+	return !fclose(file);
+}
+
+
+private void*
+alloc_get_base_ptr(
+	alloc_handle_impl_t* handle,
+	_in_ void* ptr
+	)
+{
+	if(alloc_handle_is_virtual(handle))
+	{
+		return (void*) ptr;
+	}
+
+	return MACRO_ALIGN_DOWN((void*) ptr, handle->block_size - 1);
+}
+
+
+private void
+alloc_free_remote(
+	alloc_handle_impl_t* handle,
+	_opaque_ void* ptr
+	)
+{
+	handle->remote_fn(handle, alloc_get_base_ptr(handle, ptr), (void*) ptr);
+
+#ifdef ALLOC_VALGRIND
+	VALGRIND_FREELIKE_BLOCK(ptr, 0);
+#endif
+}
+
+
+private void
+alloc_free_object(
+	_opaque_ alloc_handle_t* handle,
+	_opaque_ void* ptr,
+	alloc_t size
+	)
+{
+	assert_ptr(ptr, size);
+
+	if(!ptr)
+	{
+		return;
+	}
+
+	assert_not_null(handle, fprintf(stderr,
+		"Size 0 specified for non-empty pointer (you passed invalid parameters to alloc_free())\n"));
+
+	assert_eq((uintptr_t) ptr & alloc_get_ptr_mask((void*) handle, size), 0,
+		{
+			char format[256];
+			snprintf(format, sizeof(format),
+				"Invalid pointer alignment, got ptr = %s and size = %s "
+				"(you passed invalid parameters to alloc_free())\n",
+				MACRO_FORMAT_TYPE(ptr), MACRO_FORMAT_TYPE(size));
+			fprintf(stderr, format, ptr, size);
+		}
+		);
+
+	alloc_handle_impl_t* handle_impl = (void*) handle;
+	alloc_header_t* header = alloc_get_base_ptr(handle_impl, ptr);
+
+	if(!alloc_handle_is_virtual(handle_impl))
+	{
+		assert_eq(header->alloc_size, handle_impl->alloc_size,
+			{
+				char format[256];
+				snprintf(format, sizeof(format),
+					"Mismatch between passed size %s and (next or equal power of 2) "
+					"pointer size %s (you passed invalid parameters to alloc_free())\n",
+					MACRO_FORMAT_TYPE(size), MACRO_FORMAT_TYPE(header->alloc_size));
+				fprintf(stderr, format, size, header->alloc_size);
+			}
+			);
+	}
+
+	handle_impl->free_fn(handle_impl,
+		alloc_get_base_ptr(handle_impl, ptr), (void*) ptr, size);
+
+#ifdef ALLOC_VALGRIND
+	VALGRIND_FREELIKE_BLOCK(ptr, 0);
+#endif
+}
+
+
+private alloc_cache_t*
+alloc_create_thread_cache(
+	void
+	)
+{
+	const alloc_state* state = alloc_global_state;
+	if(!state)
+	{
+		return NULL;
+	}
+
+	alloc_cache_t* cache = alloc_alloc_virtual(sizeof(alloc_cache_t) +
+		sizeof(alloc_cache_bin_t) * state->handle_count);
+	if(!cache)
+	{
+		return NULL;
+	}
+
+	cache->bin_count = state->handle_count;
+
+	alloc_handle_impl_t* handle = (void*) state->handles;
+	alloc_cache_bin_t* bin = cache->bins;
+	alloc_cache_bin_t* bin_end = bin + cache->bin_count;
+
+	for(; bin < bin_end; ++bin, ++handle)
+	{
+		/*
+		bin->count = 0;
+		*/
+
+		if(alloc_handle_is_virtual(handle))
+		{
+			continue;
+		}
+
+		alloc_t capacity = ALLOC_CACHE_BYTES / handle->alloc_size;
+		capacity = MACRO_MIN(capacity, ALLOC_CACHE_MAX);
+
+		if(capacity >= ALLOC_CACHE_MIN)
+		{
+			bin->capacity = capacity;
+		}
+	}
+
+	int status = pthread_setspecific(alloc_cache_key, cache);
+	assert_eq(status, 0);
+
+	alloc_thread_cache = cache;
+	return cache;
+}
+
+
+void
+alloc_flush_thread_cache(
+	void
+	)
+{
+	alloc_cache_t* cache = alloc_thread_cache;
+	if(!cache)
+	{
+		return;
+	}
+
+	alloc_thread_cache = NULL;
+
+	int status = pthread_setspecific(alloc_cache_key, NULL);
+	assert_eq(status, 0);
+
+	const alloc_state* state = alloc_global_state;
+	if(state)
+	{
+		alloc_t i = 0;
+
+		for(; i < cache->bin_count; ++i)
+		{
+			alloc_cache_bin_t* bin = &cache->bins[i];
+			if(!bin->count)
+			{
+				continue;
+			}
+
+			alloc_handle_t* handle = (void*) &state->handles[i];
+			alloc_t alloc_size = ((alloc_handle_impl_t*) handle)->alloc_size;
+
+			void** ptr = bin->ptrs;
+			void** ptr_end = ptr + bin->count;
+
+			alloc_handle_lock_h(handle);
+
+			for(; ptr < ptr_end; ++ptr)
+			{
+				alloc_free_object(handle, *ptr, alloc_size);
+			}
+
+			alloc_handle_unlock_h(handle);
+		}
+	}
+
+	alloc_free_virtual(cache, sizeof(alloc_cache_t) +
+		sizeof(alloc_cache_bin_t) * cache->bin_count);
+}
+
+
+private void
+alloc_cache_key_fn(
+	void* data
+	)
+{
+	alloc_thread_cache = data;
+	alloc_flush_thread_cache();
+}
+
+
+private alloc_cache_bin_t*
+alloc_get_cache_bin(
+	_in_ alloc_handle_t* handle
+	)
+{
+	const alloc_state* state = alloc_global_state;
+	if(!state)
+	{
+		return NULL;
+	}
+
+	uintptr_t offset = (uintptr_t) handle - (uintptr_t) state->handles;
+	alloc_t idx = offset / sizeof(alloc_handle_t);
+
+	if(idx >= state->handle_count)
+	{
+		return NULL;
+	}
+
+	alloc_cache_t* cache = alloc_thread_cache;
+	if(!cache)
+	{
+		cache = alloc_create_thread_cache();
+		if(!cache)
+		{
+			return NULL;
+		}
+	}
+
+	alloc_cache_bin_t* bin = &cache->bins[idx];
+	if(!bin->capacity)
+	{
+		return NULL;
+	}
+
+	return bin;
+}
+
+
+private void*
+alloc_cache_alloc(
+	_opaque_ alloc_handle_t* handle,
+	alloc_cache_bin_t* bin,
+	alloc_t size,
+	int zero
+	)
+{
+	if(!bin->count)
+	{
+		alloc_handle_impl_t* handle_impl = (void*) handle;
+		uint32_t refill = bin->capacity >> 1;
+		void* zero_ptr = NULL;
+
+		alloc_handle_lock_h(handle);
+
+		if(zero)
+		{
+			zero_ptr = handle_impl->alloc_fn(handle_impl, size, zero);
+		}
+
+		while(bin->count < refill)
+		{
+			void* ptr = handle_impl->alloc_fn(
+				handle_impl, handle_impl->alloc_size, 0);
+			if(!ptr)
+			{
+				break;
+			}
+
+			bin->ptrs[bin->count++] = ptr;
+		}
+
+		alloc_handle_unlock_h(handle);
+
+		if(zero_ptr)
+		{
+			return zero_ptr;
+		}
+
+		if(!bin->count)
+		{
+			return NULL;
+		}
+	}
+
+	void* ptr = bin->ptrs[--bin->count];
+
+	if(zero)
+	{
+		(void) memset(ptr, 0, size);
+	}
+
+	return ptr;
+}
+
+
+private void
+alloc_cache_free(
+	_opaque_ alloc_handle_t* handle,
+	alloc_cache_bin_t* bin,
+	_opaque_ void* ptr
+	)
+{
+	if(bin->count == bin->capacity)
+	{
+		alloc_handle_impl_t* handle_impl = (void*) handle;
+		uint32_t flush = bin->capacity >> 1;
+
+		bool locked = alloc_handle_try_lock(handle_impl);
+		if(!locked && !handle_impl->remote_fn)
+		{
+			alloc_handle_lock_h(handle);
+			locked = true;
+		}
+
+		for(uint32_t i = 0; i < flush; ++i)
+		{
+			if(locked)
+			{
+				alloc_free_object(handle, bin->ptrs[i], handle_impl->alloc_size);
+			}
+			else
+			{
+				alloc_free_remote(handle_impl, bin->ptrs[i]);
+			}
+		}
+
+		if(locked)
+		{
+			alloc_handle_unlock_h(handle);
+		}
+
+		bin->count -= flush;
+		(void) memmove(bin->ptrs, bin->ptrs + flush,
+			sizeof(*bin->ptrs) * bin->count);
+	}
+
+	bin->ptrs[bin->count++] = (void*) ptr;
+}
+
+
+_alloc_func_ void*
+alloc_alloc_h(
+	_opaque_ alloc_handle_t* handle,
+	alloc_t size,
+	int zero
+	)
+{
+	if(!size)
+	{
+		return NULL;
+	}
+
+	alloc_cache_bin_t* bin = alloc_get_cache_bin(handle);
+	if(bin)
+	{
+		void* ptr = alloc_cache_alloc(handle, bin, size, zero);
+		if(ptr)
+		{
+			alloc_trace(zero ? ALLOC_TRACE_OP_CALLOC : ALLOC_TRACE_OP_ALLOC, ptr, size);
+		}
+
+		return ptr;
+	}
+
+	void* ptr;
+
+	alloc_handle_lock_h(handle);
+		ptr = alloc_alloc_uh(handle, size, zero);
+	alloc_handle_unlock_h(handle);
+
+	return ptr;
+}
+
+
+_alloc_func_ void*
+alloc_alloc_uh(
+	_opaque_ alloc_handle_t* handle,
+	alloc_t size,
+	int zero
+	)
+{
+	if(!size)
+	{
+		return NULL;
+	}
+
+	alloc_handle_impl_t* handle_impl = (void*) handle;
+
+	void* ptr = handle_impl->alloc_fn(handle_impl, size, zero);
+	if(ptr)
+	{
+		alloc_trace(zero ? ALLOC_TRACE_OP_CALLOC : ALLOC_TRACE_OP_ALLOC, ptr, size);
+	}
+
+	return ptr;
+}
+
+
+void
+alloc_free_h(
+	_opaque_ alloc_handle_t* handle,
+	_opaque_ void* ptr,
+	alloc_t size
+	)
+{
+	assert_ptr(ptr, size);
+
+	if(!ptr)
+	{
+		return;
+	}
+
+	assert_not_null(handle, fprintf(stderr,
+		"Size 0 specified for non-empty pointer (you passed invalid parameters to alloc_free())\n"));
+
+	assert_eq((uintptr_t) ptr & alloc_get_ptr_mask((void*) handle, size), 0,
+		{
+			char format[256];
+			snprintf(format, sizeof(format),
+				"Invalid pointer alignment, got ptr = %s and size = %s "
+				"(you passed invalid parameters to alloc_free())\n",
+				MACRO_FORMAT_TYPE(ptr), MACRO_FORMAT_TYPE(size));
+			fprintf(stderr, format, ptr, size);
+		}
+		);
+
+	alloc_cache_bin_t* bin = alloc_get_cache_bin(handle);
+	if(bin)
+	{
+		alloc_trace(ALLOC_TRACE_OP_FREE, ptr, size);
+		alloc_cache_free(handle, bin, ptr);
+		return;
+	}
+
+	alloc_handle_impl_t* handle_impl = (void*) handle;
+
+	if(!alloc_handle_try_lock(handle_impl))
+	{
+		if(handle_impl->remote_fn)
+		{
+			alloc_trace(ALLOC_TRACE_OP_FREE, ptr, size);
+			alloc_free_remote(handle_impl, ptr);
+			return;
+		}
+
+		alloc_handle_lock_h(handle);
+	}
+
+	alloc_free_uh(handle, ptr, size);
+	alloc_handle_unlock_h(handle);
+}
+
+
+void
+alloc_free_uh(
+	_opaque_ alloc_handle_t* handle,
+	_opaque_ void* ptr,
+	alloc_t size
+	)
+{
+	if(ptr)
+	{
+		alloc_trace(ALLOC_TRACE_OP_FREE, ptr, size);
+	}
+
+	alloc_free_object(handle, ptr, size);
+}
+
+
+bool
+alloc_alloc_batch_h(
+	_opaque_ alloc_handle_t* handle,
+	_out_ void** ptrs,
+	alloc_t count,
+	alloc_t size,
+	int zero
+	)
+{
+	assert_ptr(ptrs, count);
+
+	if(!size)
+	{
+		(void) memset(ptrs, 0, sizeof(*ptrs) * count);
+		return true;
+	}
+
+	alloc_t filled = 0;
+
+	alloc_cache_bin_t* bin = alloc_get_cache_bin(handle);
+	if(bin)
+	{
+		while(filled < count && bin->count)
+		{
+			void* ptr = bin->ptrs[--bin->count];
+
+			if(zero)
+			{
+				(void) memset(ptr, 0, size);
+			}
+
+			ptrs[filled++] = ptr;
+		}
+	}
+
+	if(filled < count)
+	{
+		bool status;
+
+		alloc_handle_lock_h(handle);
+			status = alloc_alloc_batch_uh(handle, ptrs + filled, count - filled, size, zero);
+		alloc_handle_unlock_h(handle);
+
+		if(!status)
+		{
+			while(filled)
+			{
+				bin->ptrs[bin->count++] = ptrs[--filled];
+			}
+
+			return false;
+		}
+	}
+
+	for(alloc_t i = 0; i < filled; ++i)
+	{
+		alloc_trace(zero ? ALLOC_TRACE_OP_CALLOC : ALLOC_TRACE_OP_ALLOC, ptrs[i], size);
+	}
+
+	return true;
+}
+
+
+bool
+alloc_alloc_batch_uh(
+	_opaque_ alloc_handle_t* handle,
+	_out_ void** ptrs,
+	alloc_t count,
+	alloc_t size,
+	int zero
+	)
+{
+	assert_ptr(ptrs, count);
+
+	if(!size)
+	{
+		(void) memset(ptrs, 0, sizeof(*ptrs) * count);
+		return true;
+	}
+
+	alloc_handle_impl_t* handle_impl = (void*) handle;
+
+	for(alloc_t i = 0; i < count; ++i)
+	{
+		ptrs[i] = handle_impl->alloc_fn(handle_impl, size, zero);
+		if(!ptrs[i])
+		{
+			while(i)
+			{
+				alloc_free_object(handle, ptrs[--i], size);
+			}
+
+			return false;
+		}
+	}
+
+	for(alloc_t i = 0; i < count; ++i)
+	{
+		alloc_trace(zero ? ALLOC_TRACE_OP_CALLOC : ALLOC_TRACE_OP_ALLOC, ptrs[i], size);
+	}
+
+	return true;
 }
 
 
-private int
-alloc_handle_is_virtual(
-	_in_ alloc_handle_impl_t* handle
+void
+alloc_free_batch_h(
+	_opaque_ alloc_handle_t* handle,
+	void* const* ptrs,
+	alloc_t count,
+	alloc_t size
 	)
 {
-	return !handle->block_size;
+	assert_ptr(ptrs, count);
+
+	if(!size)
+	{
+		return;
+	}
+
+	alloc_cache_bin_t* bin = alloc_get_cache_bin(handle);
+	if(bin)
+	{
+		while(count && bin->count < bin->capacity)
+		{
+			void* ptr = ptrs[--count];
+			if(ptr)
+			{
+				alloc_trace(ALLOC_TRACE_OP_FREE, ptr, size);
+				bin->ptrs[bin->count++] = ptr;
+			}
+		}
+	}
+
+	if(!count)
+	{
+		return;
+	}
+
+	alloc_handle_impl_t* handle_impl = (void*) handle;
+
+	if(!alloc_handle_try_lock(handle_impl))
+	{
+		if(handle_impl->remote_fn)
+		{
+			for(alloc_t i = 0; i < count; ++i)
+			{
+				if(ptrs[i])
+				{
+					alloc_trace(ALLOC_TRACE_OP_FREE, ptrs[i], size);
+					alloc_free_remote(handle_impl, ptrs[i]);
+				}
+			}
+
+			return;
+		}
+
+		alloc_handle_lock_h(handle);
+	}
+
+	alloc_free_batch_uh(handle, ptrs, count, size);
+	alloc_handle_unlock_h(handle);
 }
 
 
 void
-alloc_create_handle(
-	_in_ alloc_handle_info_t* info,
-	_opaque_ alloc_handle_t* handle
+alloc_free_batch_uh(
+	_opaque_ alloc_handle_t* handle,
+	void* const* ptrs,
+	alloc_t count,
+	alloc_t size
 	)
 {
-	alloc_handle_impl_t* handle_impl = (void*) handle;
+	assert_ptr(ptrs, count);
 
-	sync_mtx_init(&handle_impl->mtx);
+	for(alloc_t i = 0; i < count; ++i)
+	{
+		alloc_free_uh(handle, ptrs[i], size);
+	}
+}
 
-	handle_impl->allocators = 0;
-	handle_impl->allocations = 0;
 
-	handle_impl->head = NULL;
+#define ALLOC_REMAP_THRESHOLD MACRO_POWER_OF_2(20)
 
-	handle_impl->flags = ALLOC_HANDLE_FLAG_NONE;
 
+private void
+alloc_copy_object(
+	_in_ alloc_handle_impl_t* dst_handle,
+	void* dst,
+	_in_ alloc_handle_impl_t* src_handle,
+	_in_ void* src,
+	alloc_t size
+	)
+{
+	if(
+		size >= ALLOC_REMAP_THRESHOLD &&
+		alloc_handle_is_virtual(dst_handle) &&
+		alloc_handle_is_virtual(src_handle) &&
+		!(((uintptr_t) dst | (uintptr_t) src) & alloc_page_size_mask)
+		)
+	{
+		alloc_t remap_size = MACRO_ALIGN_DOWN(size, alloc_page_size_mask);
 
-	if(!info)
+		if(alloc_move_virtual(dst, (void*) src, remap_size))
+		{
+			dst += remap_size;
+			src += remap_size;
+			size -= remap_size;
+		}
+	}
+
+	(void) memcpy(dst, src, size);
+}
+
+
+#define ALLOC_REALLOC(alloc_fn, free_fn)							\
+do																	\
+{																	\
+	if(!new_size)													\
+	{																\
+		free_fn(old_handle, ptr, old_size);							\
+		return NULL;												\
+	}																\
+																	\
+	if(!ptr)														\
+	{																\
+		return alloc_fn(new_handle, new_size, zero);				\
+	}																\
+																	\
+	if(old_handle == new_handle)									\
+	{																\
+		if(alloc_handle_is_virtual((void*) old_handle))				\
+		{															\
+			return alloc_realloc_virtual_fn(						\
+				(void*) old_handle, ptr, old_size, new_size);		\
+		}															\
+																	\
+		if(new_size > old_size && zero)								\
+		{															\
+			alloc_zero_object((uint8_t*) ptr						\
+				+ old_size, new_size - old_size);					\
+		}															\
+																	\
+		return (void*) ptr;											\
+	}																\
+																	\
+	void* new_ptr = alloc_fn(new_handle, new_size, zero);			\
+	if(!new_ptr)													\
+	{																\
+		return NULL;												\
+	}																\
+																	\
+	alloc_copy_object((void*) new_handle, new_ptr,					\
+		(void*) old_handle, ptr, MACRO_MIN(old_size, new_size));	\
+																	\
+	free_fn(old_handle, ptr, old_size);								\
+																	\
+	return new_ptr;													\
+}																	\
+while(0)
+
+
+void*
+allow_realloc_h(
+	_opaque_ alloc_handle_t* old_handle,
+	_opaque_ void* ptr,
+	alloc_t old_size,
+	_opaque_ alloc_handle_t* new_handle,
+	alloc_t new_size,
+	int zero
+	)
+{
+	ALLOC_REALLOC(alloc_alloc_h, alloc_free_h);
+}
+
+
+void*
+allow_realloc_uh(
+	_opaque_ alloc_handle_t* old_handle,
+	_opaque_ void* ptr,
+	alloc_t old_size,
+	_opaque_ alloc_handle_t* new_handle,
+	alloc_t new_size,
+	int zero
+	)
+{
+	ALLOC_REALLOC(alloc_alloc_uh, alloc_free_uh);
+}
+
+
+#undef ALLOC_REALLOC
+#undef ALLOC_REALLOC_CHECK_VALGRIND
+
+
+void
+alloc_arena_init(
+	_out_ alloc_arena_t* arena,
+	alloc_t chunk_size,
+	alloc_page_flag_t page_flags
+	)
+{
+	assert_not_null(arena);
+
+	if(!chunk_size)
 	{
-		handle_impl->padding = 0;
-		handle_impl->alloc_limit = 0;
-		handle_impl->alloc_size = 0;
-		handle_impl->block_size = 0;
+		chunk_size = ALLOC_DEFAULT_BLOCK_SIZE;
+	}
 
-		handle_impl->alloc_fn = alloc_alloc_virtual_fn;
-		handle_impl->free_fn = alloc_free_virtual_fn;
+	arena->head = NULL;
+	arena->chunk = NULL;
+	arena->ptr = NULL;
+	arena->end = NULL;
+	arena->chunk_size = MACRO_ALIGN_UP(chunk_size, alloc_page_size_mask);
+	arena->chunk_size = alloc_get_virtual_size(arena->chunk_size, page_flags);
+	arena->page_flags = page_flags;
+}
 
-		return;
+
+void
+alloc_arena_free(
+	_inout_ alloc_arena_t* arena
+	)
+{
+	assert_not_null(arena);
+
+	alloc_arena_chunk_t* chunk = arena->head;
+
+	while(chunk)
+	{
+		alloc_arena_chunk_t* next = chunk->next;
+		alloc_free_virtual_flags(chunk, chunk->size, arena->page_flags);
+		chunk = next;
 	}
 
+	arena->head = NULL;
+	arena->chunk = NULL;
+	arena->ptr = NULL;
+	arena->end = NULL;
+}
+
 
-	assert_neq(info->alignment, 0);
-	assert_eq(MACRO_IS_POWER_OF_2(info->alignment), 1);
+private void
+alloc_arena_enter_chunk(
+	_inout_ alloc_arena_t* arena,
+	alloc_arena_chunk_t* chunk
+	)
+{
+	arena->chunk = chunk;
+	arena->ptr = chunk->data;
+	arena->end = (uint8_t*) chunk + chunk->size;
+}
 
 
-	static const alloc_t block_size_max[] =
-	(const alloc_t[])
+private bool
+alloc_arena_next_chunk(
+	_inout_ alloc_arena_t* arena,
+	alloc_t size,
+	alloc_t alignment
+	)
+{
+	alloc_t needed = sizeof(alloc_arena_chunk_t) + size + alignment - 1;
+
+	alloc_arena_chunk_t* next = arena->chunk ? arena->chunk->next : arena->head;
+	if(next && next->size >= needed)
 	{
-		0,
-		65536,
-		131072,
-		1073741824
-	};
+		alloc_arena_enter_chunk(arena, next);
+		return true;
+	}
 
-	static const alloc_t alloc_limit_max[] =
-	(const alloc_t[])
+	alloc_t chunk_size = MACRO_MAX(arena->chunk_size,
+		MACRO_ALIGN_UP(needed, alloc_page_size_mask));
+	chunk_size = alloc_get_virtual_size(chunk_size, arena->page_flags);
+
+	alloc_arena_chunk_t* chunk = alloc_alloc_virtual_flags(
+		chunk_size, arena->page_flags);
+	if(!chunk)
 	{
-		0,
-		UINT8_MAX - 2,
-		UINT16_MAX - 2,
-		UINT32_MAX - 2
-	};
+		return false;
+	}
 
-	static const alloc_alloc_fn_t alloc_fns[] =
-	(const alloc_alloc_fn_t[])
+	chunk->next = next;
+	chunk->size = chunk_size;
+
+	if(arena->chunk)
 	{
-		NULL,
-		aloc_alloc_1_fn,
-		alloc_alloc_2_fn,
-		alloc_alloc_4_fn
+		arena->chunk->next = chunk;
+	}
+	else
+	{
+		arena->head = chunk;
+	}
+
+	alloc_arena_enter_chunk(arena, chunk);
+	return true;
+}
+
+
+_alloc_func_ void*
+alloc_arena_alloc(
+	_inout_ alloc_arena_t* arena,
+	alloc_t size,
+	alloc_t alignment,
+	int zero
+	)
+{
+	assert_not_null(arena);
+	assert_ge(alignment, 1);
+	assert_eq(MACRO_IS_POWER_OF_2(alignment), 1);
+
+	if(!size)
+	{
+		return NULL;
+	}
+
+	uint8_t* ptr = MACRO_ALIGN_UP(arena->ptr, alignment - 1);
+
+	if(!arena->ptr || size > (alloc_t)(arena->end - ptr))
+	{
+		if(!alloc_arena_next_chunk(arena, size, alignment))
+		{
+			return NULL;
+		}
+
+		ptr = MACRO_ALIGN_UP(arena->ptr, alignment - 1);
+	}
+
+	arena->ptr = ptr + size;
+
+	if(zero)
+	{
+		(void) memset(ptr, 0, size);
+	}
+
+	return ptr;
+}
+
+
+void
+alloc_arena_reset(
+	_inout_ alloc_arena_t* arena
+	)
+{
+	assert_not_null(arena);
+
+	if(!arena->head)
+	{
+		return;
+	}
+
+	alloc_arena_enter_chunk(arena, arena->head);
+}
+
+
+alloc_arena_mark_t
+alloc_arena_get_mark(
+	_in_ alloc_arena_t* arena
+	)
+{
+	assert_not_null(arena);
+
+	return
+	(alloc_arena_mark_t)
+	{
+		.chunk = arena->chunk,
+		.ptr = arena->ptr
 	};
+}
+
+
+void
+alloc_arena_rewind(
+	_inout_ alloc_arena_t* arena,
+	alloc_arena_mark_t mark
+	)
+{
+	assert_not_null(arena);
 
-	static const alloc_free_fn_t free_fns[] =
-	(const alloc_free_fn_t[])
+	if(!mark.chunk)
 	{
-		NULL,
-		alloc_free_1_fn,
-		alloc_free_2_fn,
-		alloc_free_4_fn
-	};
+		alloc_arena_reset(arena);
+		return;
+	}
 
-	alloc_t table_idx = MACRO_MIN(info->alloc_size, 3U);
+	arena->chunk = mark.chunk;
+	arena->ptr = mark.ptr;
+	arena->end = (uint8_t*) mark.chunk + mark.chunk->size;
+}
 
 
-	if(info->alloc_size == 1)
+alloc_arena_t*
+alloc_get_thread_arena(
+	void
+	)
+{
+	alloc_arena_t* arena = &alloc_thread_arena;
+
+	if(!arena->chunk_size)
 	{
-		alloc_t block_size = info->block_size;
-		block_size = MACRO_MIN(block_size, block_size_max[table_idx]);
-		block_size = MACRO_MAX(block_size, alloc_page_size);
-		block_size = MACRO_NEXT_OR_EQUAL_POWER_OF_2(block_size);
+		alloc_arena_init(arena, 0, ALLOC_PAGE_FLAG_NONE);
 
-		alloc_t alloc_limit =
-			(block_size - sizeof(alloc_1_block_t)) / sizeof(alloc_1_t);
-		alloc_limit = MACRO_MIN(alloc_limit, alloc_limit_max[table_idx]);
-		alloc_limit = MACRO_MAX(alloc_limit, 1U);
+		int status = pthread_setspecific(alloc_arena_key, arena);
+		assert_eq(status, 0);
+	}
 
-		block_size = sizeof(alloc_1_block_t) + alloc_limit * sizeof(alloc_1_t);
-		block_size = MACRO_NEXT_OR_EQUAL_POWER_OF_2(block_size);
+	return arena;
+}
 
-		handle_impl->padding = 0;
-		handle_impl->alloc_limit = alloc_limit;
-		handle_impl->alloc_size = 1;
-		handle_impl->block_size = block_size;
 
-		handle_impl->alloc_fn = alloc_fns[table_idx];
-		handle_impl->free_fn = free_fns[table_idx];
+void
+alloc_free_thread_arena(
+	void
+	)
+{
+	alloc_arena_t* arena = &alloc_thread_arena;
 
+	if(!arena->chunk_size)
+	{
 		return;
 	}
 
+	alloc_arena_free(arena);
+	arena->chunk_size = 0;
 
-	alloc_t alloc_size = info->alloc_size == 2 ? sizeof(alloc_2_t) : sizeof(alloc_4_t);
+	int status = pthread_setspecific(alloc_arena_key, NULL);
+	assert_eq(status, 0);
+}
 
-	alloc_t mask = info->alignment - 1;
-	alloc_t padding = (alloc_size + mask) & ~mask;
 
-	alloc_t block_size = info->block_size;
-	block_size = MACRO_MIN(block_size, block_size_max[table_idx]);
-	block_size = MACRO_MAX(block_size, alloc_page_size);
-	block_size = MACRO_NEXT_OR_EQUAL_POWER_OF_2(block_size);
+private void
+alloc_arena_key_fn(
+	void* data
+	)
+{
+	(void) data;
 
-	alloc_t alloc_limit = (block_size - alloc_size) / info->alloc_size;
-	alloc_limit = MACRO_MIN(alloc_limit, alloc_limit_max[table_idx]);
-	alloc_limit = MACRO_MAX(alloc_limit, 1U);
+	alloc_free_thread_arena();
+}
 
-	block_size = padding + alloc_limit * info->alloc_size;
-	block_size = MACRO_NEXT_OR_EQUAL_POWER_OF_2(block_size);
 
-	handle_impl->padding = padding;
-	handle_impl->alloc_limit = alloc_limit;
-	handle_impl->alloc_size = info->alloc_size;
-	handle_impl->block_size = info->block_size;
+void
+alloc_pool_init(
+	_out_ alloc_pool_t* pool,
+	alloc_t size,
+	alloc_t slab_size,
+	alloc_pool_flag_t flags
+	)
+{
+	assert_not_null(pool);
+	assert_neq(size, 0);
 
-	handle_impl->alloc_fn = alloc_fns[table_idx];
-	handle_impl->free_fn = free_fns[table_idx];
+	sync_mtx_init(&pool->mtx);
+
+	pool->free = NULL;
+	pool->slabs = NULL;
+	pool->ptr = NULL;
+	pool->end = NULL;
+	pool->size = size;
+	pool->slab_size = slab_size;
+	atomic_init(&pool->generation, 0);
+	pool->flags = flags;
+
+	atomic_init(&pool->cache_id, 0);
 }
 
 
 void
-alloc_clone_handle(
-	_opaque_ alloc_handle_t* source,
-	_opaque_ alloc_handle_t* handle
+alloc_pool_free(
+	_inout_ alloc_pool_t* pool
 	)
 {
-	alloc_handle_impl_t* source_impl = (void*) source;
+	assert_not_null(pool);
 
-	alloc_handle_info_t info =
+	alloc_pool_reset(pool);
+
+	uint32_t cache_id = atomic_load_explicit(&pool->cache_id, memory_order_acquire);
+	if(cache_id && cache_id != ALLOC_POOL_NO_CACHE)
 	{
-		.alloc_size = source_impl->alloc_size,
-		.block_size = source_impl->block_size,
-		.alignment = source_impl->padding
-	};
+		atomic_store_explicit(&alloc_pool_registry[cache_id - 1], NULL, memory_order_release);
+	}
 
-	alloc_create_handle(&info, handle);
+	sync_mtx_free(&pool->mtx);
+}
+
+
+private alloc_t
+alloc_pool_next_generation(
+	void
+	)
+{
+	return atomic_fetch_add_explicit(&alloc_pool_generation, 1, memory_order_relaxed) + 1;
 }
 
 
 void
-alloc_free_handle(
-	_opaque_ alloc_handle_t* handle
+alloc_pool_reset(
+	_inout_ alloc_pool_t* pool
 	)
 {
-	alloc_handle_impl_t* handle_impl = (void*) handle;
+	assert_not_null(pool);
+
+	sync_mtx_lock(&pool->mtx);
 
-	if(handle_impl->head)
+	alloc_pool_slab_t* slab = pool->slabs;
+	while(slab)
 	{
-		alloc_free_virtual_aligned(
-			(void*) handle_impl->head - handle_impl->head->real_ptr_off,
-			handle_impl->block_size, handle_impl->block_size
-			);
+		alloc_pool_slab_t* next = slab->next;
+		alloc_free_h(alloc_get_handle_s(alloc_global_state, pool->slab_size),
+			slab, pool->slab_size);
+		slab = next;
 	}
 
+	pool->free = NULL;
+	pool->slabs = NULL;
+	pool->ptr = NULL;
+	pool->end = NULL;
+	atomic_store_explicit(&pool->generation,
+		alloc_pool_next_generation(), memory_order_release);
 
-	sync_mtx_free(&handle_impl->mtx);
+	sync_mtx_unlock(&pool->mtx);
 }
 
 
-private uint32_t
-alloc_default_idx_fn(
-	alloc_t size
+private alloc_t
+alloc_pool_get_stride(
+	_in_ alloc_pool_t* pool
 	)
 {
-	return MACRO_LOG2(MACRO_NEXT_OR_EQUAL_POWER_OF_2(size));
+	alloc_t stride = MACRO_ALIGN_UP(pool->size, sizeof(void*) - 1);
+	return MACRO_MAX(stride, sizeof(void*));
 }
 
 
-_alloc_func_ const alloc_state*
-alloc_alloc_state(
-	_in_ alloc_state_info_t* info
+private void*
+alloc_pool_take(
+	alloc_pool_t* pool
 	)
 {
-	if(!info)
+	void* ptr = pool->free;
+	if(ptr)
 	{
-		info = &alloc_default_state_info;
+		pool->free = *(void**) ptr;
+		return ptr;
 	}
 
+	alloc_t stride = alloc_pool_get_stride(pool);
 
-	alloc_t handle_count = info->handle_count + 1;
-	alloc_state* state = alloc_alloc_virtual(
-		sizeof(alloc_state) + sizeof(alloc_handle_t) * handle_count);
-	if(!state)
-	{
-		return NULL;
-	}
-
-	if(!info->idx_fn)
+	if(pool->ptr + stride > pool->end)
 	{
-		state->idx_fn = alloc_default_idx_fn;
-	}
-	else
-	{
-		state->idx_fn = info->idx_fn;
-	}
-
-	state->handle_count = handle_count;
+		if(!pool->slab_size)
+		{
+			pool->slab_size = ALLOC_POOL_DEFAULT_SLAB_SIZE;
+		}
 
+		pool->slab_size = MACRO_MAX(pool->slab_size, sizeof(alloc_pool_slab_t) + stride);
 
-	alloc_handle_info_t* handle_info = info->handles;
-	alloc_handle_info_t* handle_info_end = handle_info + info->handle_count;
+		alloc_pool_slab_t* slab = alloc_alloc_h(alloc_get_handle_s(
+			alloc_global_state, pool->slab_size), pool->slab_size, 0);
+		if(!slab)
+		{
+			return NULL;
+		}
 
-	alloc_handle_t* handle = state->handles;
+		slab->next = pool->slabs;
+		pool->slabs = slab;
 
-	for(; handle_info < handle_info_end; ++handle_info, ++handle)
-	{
-		alloc_create_handle(handle_info, handle);
+		pool->ptr = slab->data;
+		pool->end = (uint8_t*) slab + pool->slab_size;
 	}
 
-	alloc_create_handle(NULL, handle);
-
+	ptr = pool->ptr;
+	pool->ptr += stride;
 
-	return state;
+	return ptr;
 }
 
 
-_alloc_func_ const alloc_state*
-alloc_clone_state(
-	_in_ alloc_state* source
+private void
+alloc_pool_put(
+	alloc_pool_t* pool,
+	void* head,
+	void* tail
 	)
 {
-	alloc_t handle_count = source->handle_count;
-	alloc_t total_size = sizeof(alloc_state) + sizeof(alloc_handle_t) * handle_count;
-
-	alloc_state* state = alloc_alloc_virtual(total_size);
-	if(!state)
-	{
-		return NULL;
-	}
+	*(void**) tail = pool->free;
+	pool->free = head;
+}
 
-	(void) memcpy(state, source, total_size);
 
-	alloc_handle_impl_t* handle = (void*) state->handles;
-	alloc_handle_impl_t* handle_end = handle + handle_count;
+private uint32_t
+alloc_pool_register(
+	alloc_pool_t* pool
+	)
+{
+	sync_mtx_lock(&pool->mtx);
 
-	for(; handle < handle_end; ++handle)
+	uint32_t cache_id = atomic_load_explicit(&pool->cache_id, memory_order_relaxed);
+	if(!cache_id)
 	{
-		handle->allocators = 0;
-		handle->allocations = 0;
+		cache_id = ALLOC_POOL_NO_CACHE;
 
-		handle->flags = 0;
+		for(uint32_t idx = 0; idx < ALLOC_POOL_CACHE_MAX_POOLS; ++idx)
+		{
+			alloc_pool_t* empty = NULL;
 
-		handle->head = NULL;
+			if(atomic_compare_exchange_strong_explicit(&alloc_pool_registry[idx],
+				&empty, pool, memory_order_acq_rel, memory_order_relaxed))
+			{
+				cache_id = idx + 1;
+				break;
+			}
+		}
+
+		/* Slots are reused, so stale thread caches must never match */
+		atomic_store_explicit(&pool->generation,
+			alloc_pool_next_generation(), memory_order_release);
+		atomic_store_explicit(&pool->cache_id, cache_id, memory_order_release);
 	}
 
-	return state;
+	sync_mtx_unlock(&pool->mtx);
+
+	return cache_id;
 }
 
 
-void
-alloc_free_state(
-	_opaque_ alloc_state* state
+private alloc_pool_cache_t*
+alloc_pool_get_cache(
+	alloc_pool_t* pool
 	)
 {
-	if(!state)
+	if(!(pool->flags & ALLOC_POOL_FLAG_THREAD_CACHE))
 	{
-		state = alloc_global_state;
+		return NULL;
 	}
 
+	uint32_t cache_id = atomic_load_explicit(&pool->cache_id, memory_order_acquire);
+	if(!cache_id)
+	{
+		cache_id = alloc_pool_register(pool);
+	}
 
-	alloc_t i = 0;
-	alloc_t handle_count = state->handle_count;
+	if(cache_id == ALLOC_POOL_NO_CACHE)
+	{
+		return NULL;
+	}
 
-	for(; i < handle_count; ++i)
+	alloc_pool_thread_t* thread = alloc_thread_pools;
+	if(!thread)
 	{
-		alloc_free_handle(&state->handles[i]);
+		thread = alloc_alloc_virtual(sizeof(*thread));
+		if(!thread)
+		{
+			return NULL;
+		}
+
+		int status = pthread_setspecific(alloc_pool_key, thread);
+		assert_eq(status, 0);
+
+		alloc_thread_pools = thread;
 	}
 
-	alloc_free_virtual(state, sizeof(alloc_state) +
-		handle_count * sizeof(alloc_handle_impl_t));
+	alloc_pool_cache_t* cache = &thread->caches[cache_id - 1];
+	alloc_t generation = atomic_load_explicit(&pool->generation, memory_order_acquire);
+
+	if(cache->pool != pool || cache->generation != generation)
+	{
+		cache->pool = pool;
+		cache->generation = generation;
+		cache->head = NULL;
+		cache->count = 0;
+	}
+
+	return cache;
 }
 
 
-_pure_func_ _opaque_ alloc_handle_t*
-alloc_get_handle_s(
-	_in_ alloc_state* state,
-	alloc_t size
+_alloc_func_ void*
+alloc_pool_alloc(
+	_inout_ alloc_pool_t* pool,
+	int zero
 	)
 {
-	if(size == 0)
+	assert_not_null(pool);
+
+	void* ptr;
+
+	alloc_pool_cache_t* cache = alloc_pool_get_cache(pool);
+	if(cache)
 	{
-		return NULL;
+		if(!cache->count)
+		{
+			sync_mtx_lock(&pool->mtx);
+
+			while(cache->count < ALLOC_POOL_CACHE_COUNT / 2)
+			{
+				ptr = alloc_pool_take(pool);
+				if(!ptr)
+				{
+					break;
+				}
+
+				*(void**) ptr = cache->head;
+				cache->head = ptr;
+				++cache->count;
+			}
+
+			sync_mtx_unlock(&pool->mtx);
+
+			if(!cache->count)
+			{
+				return NULL;
+			}
+		}
+
+		ptr = cache->head;
+		cache->head = *(void**) ptr;
+		--cache->count;
 	}
+	else
+	{
+		sync_mtx_lock(&pool->mtx);
+			ptr = alloc_pool_take(pool);
+		sync_mtx_unlock(&pool->mtx);
 
-	uint32_t idx = state->idx_fn(size);
-	idx = MACRO_MIN(idx, state->handle_count - 1);
+		if(!ptr)
+		{
+			return NULL;
+		}
+	}
 
-	return &state->handles[idx];
+	if(zero)
+	{
+		(void) memset(ptr, 0, pool->size);
+	}
+
+	return ptr;
 }
 
 
 void
-alloc_handle_lock_h(
-	_opaque_ alloc_handle_t* handle
+alloc_pool_release(
+	_inout_ alloc_pool_t* pool,
+	_opaque_ void* ptr
 	)
 {
-	alloc_handle_impl_t* handle_impl = (void*) handle;
+	assert_not_null(pool);
 
-	sync_mtx_lock(&handle_impl->mtx);
-}
+	if(!ptr)
+	{
+		return;
+	}
 
+	alloc_pool_cache_t* cache = alloc_pool_get_cache(pool);
+	if(!cache)
+	{
+		sync_mtx_lock(&pool->mtx);
+			alloc_pool_put(pool, (void*) ptr, (void*) ptr);
+		sync_mtx_unlock(&pool->mtx);
 
-void
-alloc_handle_unlock_h(
-	_opaque_ alloc_handle_t* handle
-	)
-{
-	alloc_handle_impl_t* handle_impl = (void*) handle;
+		return;
+	}
 
-	sync_mtx_unlock(&handle_impl->mtx);
-}
+	if(cache->count == ALLOC_POOL_CACHE_COUNT)
+	{
+		void* head = cache->head;
+		void* tail = head;
 
+		for(alloc_t i = 1; i < ALLOC_POOL_CACHE_COUNT / 2; ++i)
+		{
+			tail = *(void**) tail;
+		}
 
-void
-alloc_handle_set_flags_h(
-	_opaque_ alloc_handle_t* handle,
-	alloc_handle_flag_t flags
-	)
-{
-	alloc_handle_lock_h(handle);
-		alloc_handle_set_flags_uh(handle, flags);
-	alloc_handle_unlock_h(handle);
+		cache->head = *(void**) tail;
+		cache->count -= ALLOC_POOL_CACHE_COUNT / 2;
+
+		sync_mtx_lock(&pool->mtx);
+			alloc_pool_put(pool, head, tail);
+		sync_mtx_unlock(&pool->mtx);
+	}
+
+	*(void**) ptr = cache->head;
+	cache->head = (void*) ptr;
+	++cache->count;
 }
 
 
 void
-alloc_handle_set_flags_uh(
-	_opaque_ alloc_handle_t* handle,
-	alloc_handle_flag_t flags
+alloc_flush_thread_pools(
+	void
 	)
 {
-	alloc_handle_impl_t* handle_impl = (void*) handle;
+	alloc_pool_thread_t* thread = alloc_thread_pools;
+	if(!thread)
+	{
+		return;
+	}
 
-	handle_impl->flags = flags;
-}
+	alloc_thread_pools = NULL;
 
+	int status = pthread_setspecific(alloc_pool_key, NULL);
+	assert_eq(status, 0);
 
-void
-alloc_handle_add_flags_h(
-	_opaque_ alloc_handle_t* handle,
-	alloc_handle_flag_t flags
-	)
-{
-	alloc_handle_lock_h(handle);
-		alloc_handle_add_flags_uh(handle, flags);
-	alloc_handle_unlock_h(handle);
-}
+	for(uint32_t i = 0; i < ALLOC_POOL_CACHE_MAX_POOLS; ++i)
+	{
+		alloc_pool_cache_t* cache = &thread->caches[i];
+		alloc_pool_t* pool = cache->pool;
+
+		if(
+			!cache->count ||
+			atomic_load_explicit(&alloc_pool_registry[i], memory_order_acquire) != pool ||
+			cache->generation != atomic_load_explicit(
+				&pool->generation, memory_order_acquire)
+			)
+		{
+			continue;
+		}
 
+		void* tail = cache->head;
+		while(*(void**) tail)
+		{
+			tail = *(void**) tail;
+		}
 
-void
-alloc_handle_add_flags_uh(
-	_opaque_ alloc_handle_t* handle,
-	alloc_handle_flag_t flags
-	)
-{
-	alloc_handle_impl_t* handle_impl = (void*) handle;
+		sync_mtx_lock(&pool->mtx);
+			alloc_pool_put(pool, cache->head, tail);
+		sync_mtx_unlock(&pool->mtx);
+	}
 
-	handle_impl->flags |= flags;
+	alloc_free_virtual(thread, sizeof(*thread));
 }
 
 
-void
-alloc_handle_del_flags_h(
-	_opaque_ alloc_handle_t* handle,
-	alloc_handle_flag_t flags
+private void
+alloc_pool_key_fn(
+	void* data
 	)
 {
-	alloc_handle_lock_h(handle);
-		alloc_handle_del_flags_uh(handle, flags);
-	alloc_handle_unlock_h(handle);
+	alloc_thread_pools = data;
+	alloc_flush_thread_pools();
 }
 
 
-void
-alloc_handle_del_flags_uh(
-	_opaque_ alloc_handle_t* handle,
-	alloc_handle_flag_t flags
-	)
+struct alloc_region_large
 {
-	alloc_handle_impl_t* handle_impl = (void*) handle;
+	alloc_region_large_t* next;
+	alloc_region_large_t* prev;
+	alloc_t size;
+};
 
-	handle_impl->flags &= ~flags;
-}
 
+#define ALLOC_REGION_LARGE_OFFSET MACRO_ALIGN_UP_CONST(sizeof(alloc_region_large_t), 15)
 
-alloc_handle_flag_t
-alloc_handle_get_flags_h(
-	_opaque_ alloc_handle_t* handle
+
+void
+alloc_region_init(
+	_out_ alloc_region_t* region
 	)
 {
-	alloc_handle_flag_t flags;
+	assert_not_null(region);
+	assert_not_null(alloc_global_state);
 
-	alloc_handle_lock_h(handle);
-		flags = alloc_handle_get_flags_uh(handle);
-	alloc_handle_unlock_h(handle);
+	region->state = alloc_clone_state(alloc_global_state);
+	hard_assert_not_null(region->state);
 
-	return flags;
+	region->large = NULL;
 }
 
 
-alloc_handle_flag_t
-alloc_handle_get_flags_uh(
-	_opaque_ alloc_handle_t* handle
+void
+alloc_region_free(
+	_inout_ alloc_region_t* region
 	)
 {
-	alloc_handle_impl_t* handle_impl = (void*) handle;
-
-	return handle_impl->flags;
-}
-
+	assert_not_null(region);
 
-private void*
-alloc_get_base_ptr(
-	alloc_handle_impl_t* handle,
-	_in_ void* ptr
-	)
-{
-	if(alloc_handle_is_virtual(handle))
+	alloc_region_large_t* large = region->large;
+	while(large)
 	{
-		return (void*) ptr;
+		alloc_region_large_t* next = large->next;
+		alloc_free_virtual(large, large->size);
+		large = next;
 	}
 
-	return MACRO_ALIGN_DOWN((void*) ptr, handle->block_size - 1);
+	alloc_free_state(region->state);
+
+	region->state = NULL;
+	region->large = NULL;
 }
 
 
 _alloc_func_ void*
-alloc_alloc_h(
-	_opaque_ alloc_handle_t* handle,
+alloc_region_alloc(
+	_inout_ alloc_region_t* region,
 	alloc_t size,
 	int zero
 	)
 {
+	assert_not_null(region);
+
 	if(!size)
 	{
 		return NULL;
 	}
 
-	void* ptr;
-
-	alloc_handle_lock_h(handle);
-		ptr = alloc_alloc_uh(handle, size, zero);
-	alloc_handle_unlock_h(handle);
+	_opaque_ alloc_handle_t* handle = alloc_get_handle_s(region->state, size);
 
-	return ptr;
-}
+	if(!alloc_handle_is_virtual((void*) handle))
+	{
+		return alloc_alloc_uh(handle, size, zero);
+	}
 
+	alloc_t large_size = ALLOC_REGION_LARGE_OFFSET + size;
 
-_alloc_func_ void*
-alloc_alloc_uh(
-	_opaque_ alloc_handle_t* handle,
-	alloc_t size,
-	int zero
-	)
-{
-	if(!size)
+	alloc_region_large_t* large = alloc_alloc_virtual(large_size);
+	if(!large)
 	{
 		return NULL;
 	}
 
-	alloc_handle_impl_t* handle_impl = (void*) handle;
+	large->next = region->large;
+	large->prev = NULL;
+	large->size = large_size;
+
+	if(region->large)
+	{
+		region->large->prev = large;
+	}
 
-	return handle_impl->alloc_fn(handle_impl, size, zero);
+	region->large = large;
+
+	return (uint8_t*) large + ALLOC_REGION_LARGE_OFFSET;
 }
 
 
 void
-alloc_free_h(
-	_opaque_ alloc_handle_t* handle,
+alloc_region_release(
+	_inout_ alloc_region_t* region,
 	_opaque_ void* ptr,
 	alloc_t size
 	)
 {
+	assert_not_null(region);
 	assert_ptr(ptr, size);
 
 	if(!ptr)
@@ -1628,149 +4951,145 @@ alloc_free_h(
 		return;
 	}
 
-	assert_not_null(handle, fprintf(stderr,
-		"Size 0 specified for non-empty pointer (you passed invalid parameters to alloc_free())\n"));
-
-	assert_eq((uintptr_t) ptr & MACRO_POWER_OF_2_MASK(size), 0,
-		{
-			char format[256];
-			snprintf(format, sizeof(format),
-				"Invalid pointer alignment, got ptr = %s and size = %s "
-				"(you passed invalid parameters to alloc_free())\n",
-				MACRO_FORMAT_TYPE(ptr), MACRO_FORMAT_TYPE(size));
-			fprintf(stderr, format, ptr, size);
-		}
-		);
+	_opaque_ alloc_handle_t* handle = alloc_get_handle_s(region->state, size);
 
-	alloc_handle_lock_h(handle);
+	if(!alloc_handle_is_virtual((void*) handle))
+	{
 		alloc_free_uh(handle, ptr, size);
-	alloc_handle_unlock_h(handle);
+		return;
+	}
+
+	alloc_region_large_t* large = (void*)((uint8_t*) ptr - ALLOC_REGION_LARGE_OFFSET);
+	assert_eq(large->size, ALLOC_REGION_LARGE_OFFSET + size);
+
+	if(large->prev)
+	{
+		large->prev->next = large->next;
+	}
+	else
+	{
+		region->large = large->next;
+	}
+
+	if(large->next)
+	{
+		large->next->prev = large->prev;
+	}
+
+	alloc_free_virtual(large, large->size);
 }
 
 
 void
-alloc_free_uh(
-	_opaque_ alloc_handle_t* handle,
-	_opaque_ void* ptr,
-	alloc_t size
+alloc_vec_init(
+	_out_ alloc_vec_t* vec,
+	alloc_t elem_size,
+	alloc_t max_count
 	)
 {
-	assert_ptr(ptr, size);
+	assert_not_null(vec);
+	assert_neq(elem_size, 0);
+	assert_neq(max_count, 0);
 
-	if(!ptr)
-	{
-		return;
-	}
+	alloc_t reserved = MACRO_ALIGN_UP((elem_size * max_count), alloc_page_size_mask);
 
-	assert_not_null(handle, fprintf(stderr,
-		"Size 0 specified for non-empty pointer (you passed invalid parameters to alloc_free())\n"));
+	vec->data = alloc_reserve_virtual(reserved);
+	assert_not_null(vec->data);
+
+	vec->count = 0;
+	vec->elem_size = elem_size;
+	vec->committed = 0;
+	vec->reserved = reserved;
+}
+
+
+void
+alloc_vec_free(
+	_inout_ alloc_vec_t* vec
+	)
+{
+	assert_not_null(vec);
+
+	alloc_free_virtual(vec->data, vec->reserved);
+}
+
+
+bool
+alloc_vec_resize(
+	_inout_ alloc_vec_t* vec,
+	alloc_t count
+	)
+{
+	assert_not_null(vec);
+
+	alloc_t size = vec->elem_size * count;
 
-	assert_eq((uintptr_t) ptr & MACRO_POWER_OF_2_MASK(size), 0,
+	if(size > vec->committed)
+	{
+		if(size > vec->reserved)
 		{
-			char format[256];
-			snprintf(format, sizeof(format),
-				"Invalid pointer alignment, got ptr = %s and size = %s "
-				"(you passed invalid parameters to alloc_free())\n",
-				MACRO_FORMAT_TYPE(ptr), MACRO_FORMAT_TYPE(size));
-			fprintf(stderr, format, ptr, size);
+			return false;
 		}
-		);
 
-	alloc_handle_impl_t* handle_impl = (void*) handle;
-	alloc_header_t* header = alloc_get_base_ptr(handle_impl, ptr);
+		alloc_t committed = MACRO_ALIGN_UP(
+			MACRO_MAX(size, vec->committed << 1), alloc_page_size_mask);
+		committed = MACRO_MIN(committed, vec->reserved);
 
-	assert_eq(header->alloc_size, handle_impl->alloc_size,
+		if(!alloc_commit_virtual((uint8_t*) vec->data
+			+ vec->committed, committed - vec->committed))
 		{
-			char format[256];
-			snprintf(format, sizeof(format),
-				"Mismatch between passed size %s and (next or equal power of 2) "
-				"pointer size %s (you passed invalid parameters to alloc_free())\n",
-				MACRO_FORMAT_TYPE(size), MACRO_FORMAT_TYPE(header->alloc_size));
-			fprintf(stderr, format, size, header->alloc_size);
+			return false;
 		}
-		);
 
-	handle_impl->free_fn(handle_impl,
-		alloc_get_base_ptr(handle_impl, ptr), (void*) ptr, size);
+		vec->committed = committed;
+	}
+	else if(size < (vec->committed >> 2))
+	{
+		alloc_t committed = MACRO_ALIGN_UP((size << 1), alloc_page_size_mask);
 
-#ifdef ALLOC_VALGRIND
-	VALGRIND_FREELIKE_BLOCK(ptr, 0);
-#endif
-}
+		if(committed < vec->committed)
+		{
+			alloc_decommit_virtual((uint8_t*) vec->data
+				+ committed, vec->committed - committed);
 
+			vec->committed = committed;
+		}
+	}
 
-#define ALLOC_REALLOC(alloc_fn, free_fn)							\
-do																	\
-{																	\
-	if(!new_size)													\
-	{																\
-		free_fn(old_handle, ptr, old_size);							\
-		return NULL;												\
-	}																\
-																	\
-	if(!ptr)														\
-	{																\
-		return alloc_fn(new_handle, new_size, zero);				\
-	}																\
-																	\
-	if(old_handle == new_handle)									\
-	{																\
-		if(alloc_handle_is_virtual((void*) old_handle))				\
-		{															\
-			return alloc_realloc_virtual(ptr, old_size, new_size);	\
-		}															\
-																	\
-		if(new_size > old_size && zero)								\
-		{															\
-			(void) memset((uint8_t*) ptr							\
-				+ old_size, 0, new_size - old_size);				\
-		}															\
-																	\
-		return (void*) ptr;											\
-	}																\
-																	\
-	void* new_ptr = alloc_fn(new_handle, new_size, zero);			\
-	if(!new_ptr)													\
-	{																\
-		return NULL;												\
-	}																\
-																	\
-	(void) memcpy(new_ptr, ptr, MACRO_MIN(old_size, new_size));		\
-																	\
-	free_fn(old_handle, ptr, old_size);								\
-																	\
-	return new_ptr;													\
-}																	\
-while(0)
+	vec->count = count;
+
+	return true;
+}
 
 
 void*
-allow_realloc_h(
-	_opaque_ alloc_handle_t* old_handle,
-	_opaque_ void* ptr,
-	alloc_t old_size,
-	_opaque_ alloc_handle_t* new_handle,
-	alloc_t new_size,
-	int zero
+alloc_vec_push(
+	_inout_ alloc_vec_t* vec,
+	alloc_t count
 	)
 {
-	ALLOC_REALLOC(alloc_alloc_h, alloc_free_h);
+	assert_not_null(vec);
+
+	alloc_t idx = vec->count;
+
+	if(!alloc_vec_resize(vec, idx + count))
+	{
+		return NULL;
+	}
+
+	return (uint8_t*) vec->data + vec->elem_size * idx;
 }
 
 
-void*
-allow_realloc_uh(
-	_opaque_ alloc_handle_t* old_handle,
-	_opaque_ void* ptr,
-	alloc_t old_size,
-	_opaque_ alloc_handle_t* new_handle,
-	alloc_t new_size,
-	int zero
+void
+alloc_vec_pop(
+	_inout_ alloc_vec_t* vec,
+	alloc_t count
 	)
 {
-	ALLOC_REALLOC(alloc_alloc_uh, alloc_free_uh);
-}
+	assert_not_null(vec);
+	assert_le(count, vec->count);
 
-
-#undef ALLOC_REALLOC
-#undef ALLOC_REALLOC_CHECK_VALGRIND
+	bool status = alloc_vec_resize(vec, vec->count - count);
+	assert_true(status);
+}
@@ -17,8 +17,10 @@
 #include <thesis/vk.h>
 #include <thesis/app.h>
 #include <thesis/file.h>
+#include <thesis/time.h>
 #include <thesis/debug.h>
 #include <thesis/options.h>
+#include <thesis/threads.h>
 #include <thesis/alloc_ext.h>
 #include <thesis/simulation.h>
 
@@ -30,8 +32,12 @@
 #include <unistd.h>
 
 
+#define APP_ALLOC_PURGE_INTERVAL_MS 1000
+
+
 struct app
 {
+	time_timers_t timers;
 	simulation_t simulation;
 	vk_t vk;
 };
@@ -64,6 +70,32 @@ app_init(
 
 	global_options = options_init(argc, (void*) argv);
 
+	sync_rcu_read_lock();
+		str_t spin_ns = options_get(global_options, "thread-spin-ns");
+		if(spin_ns)
+		{
+			thread_set_spin_ns(strtoull(spin_ns->str, NULL, 10));
+		}
+	sync_rcu_read_unlock();
+
+	app->timers = time_timers_init();
+
+	time_timers_add_interval(
+		app->timers,
+		(time_interval_t)
+		{
+			.timer = NULL,
+			.data =
+			{
+				.fn = (void*) alloc_purge_s,
+				.data = NULL
+			},
+			.base_time = time_get(),
+			.interval = time_ms_to_ns(APP_ALLOC_PURGE_INTERVAL_MS),
+			.count = 1
+		}
+		);
+
 	app->simulation = simulation_init(
 		(simulation_camera_t)
 		{
@@ -101,6 +133,8 @@ app_free(
 
 	simulation_free(app->simulation);
 
+	time_timers_free(app->timers);
+
 	options_free(global_options);
 	global_options = NULL;
 
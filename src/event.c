@@ -53,14 +53,29 @@ typedef struct event_once_data
 event_once_data_t;
 
 
+typedef struct event_once_listener
+{
+	event_listener_t listener;
+	event_once_data_t once;
+}
+event_once_listener_t;
+
+
+private alloc_pool_t event_listener_pool =
+	ALLOC_POOL_INIT(event_listener_t, ALLOC_POOL_FLAG_THREAD_CACHE);
+
+private alloc_pool_t event_once_listener_pool =
+	ALLOC_POOL_INIT(event_once_listener_t, ALLOC_POOL_FLAG_THREAD_CACHE);
+
+
 private void
 event_once_fn(
-	event_listener_t* listener,
+	event_once_listener_t* once_listener,
 	void* event_data
 	)
 {
-	event_once_data_t once = *(event_once_data_t*)(listener + 1);
-	event_target_del_once(once.target, listener);
+	event_once_data_t once = once_listener->once;
+	event_target_del_once(once.target, &once_listener->listener);
 	once.data.fn(once.data.data, event_data);
 }
 
@@ -79,14 +94,10 @@ event_target_add_common(
 
 	if(once)
 	{
-		event_once_data_t* once_data;
-
-		listener = alloc_malloc(sizeof(*listener) + sizeof(*once_data));
-		assert_not_null(listener);
-
-		once_data = (void*)(listener + 1);
+		event_once_listener_t* once_listener = alloc_pool_alloc(&event_once_listener_pool, 0);
+		assert_not_null(once_listener);
 
-		*once_data =
+		once_listener->once =
 		(event_once_data_t)
 		{
 			.target = target,
@@ -97,12 +108,14 @@ event_target_add_common(
 		(event_listener_data_t)
 		{
 			.fn = (void*) event_once_fn,
-			.data = listener
+			.data = once_listener
 		};
+
+		listener = &once_listener->listener;
 	}
 	else
 	{
-		listener = alloc_malloc(sizeof(*listener));
+		listener = alloc_pool_alloc(&event_listener_pool, 0);
 		assert_not_null(listener);
 	}
 
@@ -145,7 +158,7 @@ private void
 event_target_del_common(
 	event_target_t* target,
 	event_listener_t* listener,
-	alloc_t size
+	alloc_pool_t* pool
 	)
 {
 	assert_not_null(target);
@@ -187,7 +200,7 @@ event_target_del_common(
 		listener->next->prev = listener->prev;
 	}
 
-	alloc_free(listener, size);
+	alloc_pool_release(pool, listener);
 }
 
 
@@ -197,7 +210,7 @@ event_target_del(
 	event_listener_t* listener
 	)
 {
-	event_target_del_common(target, listener, sizeof(*listener));
+	event_target_del_common(target, listener, &event_listener_pool);
 }
 
 
@@ -207,8 +220,7 @@ event_target_del_once(
 	event_listener_t* listener
 	)
 {
-	event_target_del_common(target, listener,
-		sizeof(*listener) + sizeof(event_once_data_t));
+	event_target_del_common(target, listener, &event_once_listener_pool);
 }
 
 
@@ -41,6 +41,8 @@ model_init(
 	model_t* model = alloc_malloc(sizeof(*model));
 	assert_not_null(model);
 
+	alloc_region_init(&model->region);
+
 	const struct aiScene* scene = aiImportFile(
 		path,
 		aiProcess_GenNormals |
@@ -69,7 +71,8 @@ model_init(
 	assert_gt(scene->mNumMeshes, 0);
 
 	model->material_count = scene->mNumMaterials;
-	model->materials = alloc_malloc(sizeof(*model->materials) * model->material_count);
+	model->materials = alloc_region_alloc(&model->region,
+		sizeof(*model->materials) * model->material_count, 0);
 	assert_not_null(model->materials);
 
 	for(uint32_t i = 0; i < model->material_count; i++)
@@ -100,7 +103,8 @@ model_init(
 	}
 
 	model->mesh_count = scene->mNumMeshes;
-	model->meshes = alloc_malloc(sizeof(*model->meshes) * model->mesh_count);
+	model->meshes = alloc_region_alloc(&model->region,
+		sizeof(*model->meshes) * model->mesh_count, 0);
 	assert_not_null(model->meshes);
 
 	for(uint32_t i = 0; i < model->mesh_count; i++)
@@ -117,13 +121,16 @@ model_init(
 		mesh->vertex_count = sceneMesh->mNumVertices;
 		assert_gt(mesh->vertex_count, 0);
 
-		mesh->vertices = alloc_malloc(sizeof(*mesh->vertices) * mesh->vertex_count);
+		mesh->vertices = alloc_region_alloc(&model->region,
+			sizeof(*mesh->vertices) * mesh->vertex_count, 0);
 		assert_not_null(mesh->vertices);
 
-		mesh->normals = alloc_malloc(sizeof(*mesh->normals) * mesh->vertex_count);
+		mesh->normals = alloc_region_alloc(&model->region,
+			sizeof(*mesh->normals) * mesh->vertex_count, 0);
 		assert_not_null(mesh->normals);
 
-		mesh->coords = alloc_malloc(sizeof(*mesh->coords) * mesh->vertex_count);
+		mesh->coords = alloc_region_alloc(&model->region,
+			sizeof(*mesh->coords) * mesh->vertex_count, 0);
 		assert_not_null(mesh->coords);
 
 		for(uint32_t j = 0; j < mesh->vertex_count; j++)
@@ -134,7 +141,8 @@ model_init(
 		}
 
 		mesh->index_count = sceneMesh->mNumFaces * 3;
-		mesh->indexes = alloc_malloc(sizeof(*mesh->indexes) * mesh->index_count);
+		mesh->indexes = alloc_region_alloc(&model->region,
+			sizeof(*mesh->indexes) * mesh->index_count, 0);
 		assert_not_null(mesh->indexes);
 
 		for(uint32_t j = 0; j < sceneMesh->mNumFaces; j++)
@@ -161,20 +169,6 @@ model_free(
 {
 	assert_not_null(model);
 
-	for(uint32_t i = 0; i < model->mesh_count; i++)
-	{
-		mesh_t* mesh = &model->meshes[i];
-		assert_not_null(mesh);
-
-		alloc_free(mesh->indexes, sizeof(*mesh->indexes) * mesh->index_count);
-
-		alloc_free(mesh->coords, sizeof(*mesh->coords) * mesh->vertex_count);
-		alloc_free(mesh->normals, sizeof(*mesh->normals) * mesh->vertex_count);
-		alloc_free(mesh->vertices, sizeof(*mesh->vertices) * mesh->vertex_count);
-	}
-
-	alloc_free(model->meshes, sizeof(*model->meshes) * model->mesh_count);
-
 	for(uint32_t i = 0; i < model->material_count; i++)
 	{
 		material_t* material = &model->materials[i];
@@ -183,7 +177,7 @@ model_free(
 		str_free(material->texture);
 	}
 
-	alloc_free(model->materials, sizeof(*model->materials) * model->material_count);
+	alloc_region_free(&model->region);
 
 	alloc_free(model, sizeof(*model));
 }
@@ -20,6 +20,7 @@
 #include <thesis/alloc_ext.h>
 
 #include <string.h>
+#include <stdatomic.h>
 
 
 options_t global_options = NULL;
@@ -27,7 +28,8 @@ options_t global_options = NULL;
 
 struct options
 {
-	hash_table_t table;
+	sync_mtx_t mtx;
+	hash_table_t _Atomic table;
 };
 
 
@@ -42,13 +44,57 @@ options_key_free_fn(
 
 private void
 options_value_free_fn(
-	str_t value
+	str_t key,
+	str_t value,
+	void* data
 	)
 {
 	str_free(value);
 }
 
 
+private hash_table_t
+options_table_init(
+	void
+	)
+{
+	/* Values are shared between table versions and freed one at a time */
+	return hash_table_init(16, (void*) options_key_free_fn, NULL);
+}
+
+
+private void
+options_table_copy_fn(
+	str_t key,
+	str_t value,
+	hash_table_t table
+	)
+{
+	hash_table_set(table, cstr_init_len(key->str, key->len), value);
+}
+
+
+private hash_table_t
+options_table_copy(
+	hash_table_t table
+	)
+{
+	hash_table_t copy = options_table_init();
+	hash_table_for_each(table, (void*) options_table_copy_fn, copy);
+
+	return copy;
+}
+
+
+private hash_table_t
+options_get_table(
+	options_t options
+	)
+{
+	return atomic_load_explicit(&options->table, memory_order_acquire);
+}
+
+
 options_t
 options_init(
 	int argc,
@@ -58,8 +104,9 @@ options_init(
 	options_t options = alloc_malloc(sizeof(*options));
 	assert_not_null(options);
 
-	options->table = hash_table_init(16,
-		(void*) options_key_free_fn, (void*) options_value_free_fn);
+	sync_mtx_init(&options->mtx);
+
+	hash_table_t table = options_table_init();
 
 	const char* const* arg = argv + 1;
 	const char* const* arg_end = argv + argc;
@@ -84,9 +131,12 @@ options_init(
 			value_str = str_init_copy_cstr(++value);
 		}
 
-		hash_table_set(options->table, key, value_str);
+		str_free(hash_table_get(table, key));
+		hash_table_set(table, key, value_str);
 	}
 
+	atomic_init(&options->table, table);
+
 	return options;
 }
 
@@ -98,7 +148,13 @@ options_free(
 {
 	assert_not_null(options);
 
-	hash_table_free(options->table);
+	sync_rcu_barrier();
+
+	hash_table_t table = options_get_table(options);
+	hash_table_for_each(table, (void*) options_value_free_fn, NULL);
+
+	hash_table_free(table);
+	sync_mtx_free(&options->mtx);
 
 	alloc_free(options, sizeof(*options));
 }
@@ -115,7 +171,23 @@ options_set(
 	assert_not_null(key);
 
 	key = cstr_init(key);
-	hash_table_set(options->table, key, value);
+
+	sync_mtx_lock(&options->mtx);
+		hash_table_t old_table = options_get_table(options);
+		str_t old_value = hash_table_get(old_table, key);
+
+		hash_table_t table = options_table_copy(old_table);
+
+		hash_table_set(table, key, value);
+		atomic_store_explicit(&options->table, table, memory_order_release);
+	sync_mtx_unlock(&options->mtx);
+
+	sync_rcu_call((void*) hash_table_free, old_table);
+
+	if(old_value)
+	{
+		sync_rcu_call((void*) str_free, old_value);
+	}
 }
 
 
@@ -129,8 +201,24 @@ options_set_default(
 	assert_not_null(options);
 	assert_not_null(key);
 
-	key = cstr_init(key);
-	hash_table_add(options->table, key, value);
+	sync_mtx_lock(&options->mtx);
+		hash_table_t old_table = options_get_table(options);
+
+		if(hash_table_has(old_table, key))
+		{
+			sync_mtx_unlock(&options->mtx);
+			str_free(value);
+
+			return;
+		}
+
+		hash_table_t table = options_table_copy(old_table);
+
+		hash_table_add(table, cstr_init(key), value);
+		atomic_store_explicit(&options->table, table, memory_order_release);
+	sync_mtx_unlock(&options->mtx);
+
+	sync_rcu_call((void*) hash_table_free, old_table);
 }
 
 
@@ -143,7 +231,7 @@ options_get(
 	assert_not_null(options);
 	assert_not_null(key);
 
-	return hash_table_get(options->table, key);
+	return hash_table_get(options_get_table(options), key);
 }
 
 
@@ -156,5 +244,9 @@ options_exists(
 	assert_not_null(options);
 	assert_not_null(key);
 
-	return hash_table_has(options->table, key);
+	sync_rcu_read_lock();
+		bool status = hash_table_has(options_get_table(options), key);
+	sync_rcu_read_unlock();
+
+	return status;
 }
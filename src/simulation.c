@@ -16,12 +16,17 @@
 
 #include <thesis/hash.h>
 #include <thesis/debug.h>
+#include <thesis/threads.h>
 #include <thesis/alloc_ext.h>
 #include <thesis/simulation.h>
 
 #include <stdatomic.h>
 
 
+#define SIMULATION_MAX_MODELS MACRO_POWER_OF_2(16)
+#define SIMULATION_MAX_ENTITIES MACRO_POWER_OF_2(24)
+
+
 typedef struct simulation_entity
 {
 	uint32_t model_index;
@@ -33,19 +38,23 @@ simulation_entity_t;
 
 struct simulation
 {
+	sync_seqlock_t camera_lock;
 	simulation_camera_t camera;
 
 	model_t** models;
-	uint32_t model_count;
+	alloc_vec_t models_vec;
 
 	hash_table_t model_table;
 
 	simulation_entity_t* entities;
-	uint32_t entity_count;
+	alloc_vec_t entities_vec;
 
 	atomic_flag stopped;
 
 	simulation_event_table_t event_table;
+
+	thread_topology_t topology;
+	thread_sched_t sched;
 };
 
 
@@ -57,20 +66,33 @@ simulation_init(
 	simulation_t simulation = alloc_malloc(sizeof(*simulation));
 	assert_not_null(simulation);
 
+	sync_seqlock_init(&simulation->camera_lock);
 	simulation->camera = camera;
 
-	simulation->models = NULL;
-	simulation->model_count = 0;
+	alloc_vec_init(&simulation->models_vec,
+		sizeof(*simulation->models), SIMULATION_MAX_MODELS);
+	simulation->models = simulation->models_vec.data;
 
 	simulation->model_table = hash_table_init(8, NULL, NULL);
 
-	simulation->entities = NULL;
-	simulation->entity_count = 0;
+	alloc_vec_init(&simulation->entities_vec,
+		sizeof(*simulation->entities), SIMULATION_MAX_ENTITIES);
+	simulation->entities = simulation->entities_vec.data;
 
 	atomic_flag_clear(&simulation->stopped);
 
 	event_target_init(&simulation->event_table.free_target);
 
+	thread_topology_init(&simulation->topology);
+	uint32_t core_count = simulation->topology.core_count;
+
+	thread_sched_init(&simulation->sched, MACRO_MAX(core_count - 1, 1U));
+
+	if(core_count > 1)
+	{
+		thread_sched_pin(&simulation->sched, &simulation->topology, 1);
+	}
+
 	return simulation;
 }
 
@@ -90,16 +112,21 @@ simulation_free(
 
 	event_target_free(&simulation->event_table.free_target);
 
-	alloc_free(simulation->entities, sizeof(*simulation->entities) * simulation->entity_count);
+	thread_sched_free(&simulation->sched);
+	thread_topology_free(&simulation->topology);
+
+	alloc_vec_free(&simulation->entities_vec);
 
 	hash_table_free(simulation->model_table);
 
-	for(uint32_t i = 0; i < simulation->model_count; ++i)
+	for(uint32_t i = 0; i < simulation->models_vec.count; ++i)
 	{
 		model_free(simulation->models[i]);
 	}
 
-	alloc_free(simulation->models, sizeof(*simulation->models) * simulation->model_count);
+	alloc_vec_free(&simulation->models_vec);
+
+	sync_seqlock_free(&simulation->camera_lock);
 
 	alloc_free(simulation, sizeof(*simulation));
 }
@@ -124,14 +151,8 @@ simulation_add_entity(
 {
 	assert_not_null(simulation);
 
-	simulation->entities = alloc_remalloc(
-		simulation->entities,
-		sizeof(*simulation->entities) * simulation->entity_count,
-		sizeof(*simulation->entities) * (simulation->entity_count + 1)
-		);
-	assert_not_null(simulation->entities);
-
-	simulation_entity_t* entity = &simulation->entities[simulation->entity_count++];
+	simulation_entity_t* entity = alloc_vec_push(&simulation->entities_vec, 1);
+	assert_not_null(entity);
 
 	uintptr_t model = (uintptr_t) hash_table_get(
 		simulation->model_table,
@@ -140,22 +161,18 @@ simulation_add_entity(
 
 	if(!model)
 	{
-		simulation->models = alloc_remalloc(
-			simulation->models,
-			sizeof(*simulation->models) * simulation->model_count,
-			sizeof(*simulation->models) * (simulation->model_count + 1)
-			);
-		assert_not_null(simulation->models);
+		model_t** model_ptr = alloc_vec_push(&simulation->models_vec, 1);
+		assert_not_null(model_ptr);
+
+		*model_ptr = model_init(entity_init.model_path);
 
-		simulation->models[simulation->model_count++] =
-			model_init(entity_init.model_path);
+		model = simulation->models_vec.count;
 
 		hash_table_set(
 			simulation->model_table,
 			entity_init.model_path,
-			(void*) (uintptr_t) simulation->model_count
+			(void*) model
 			);
-		model = simulation->model_count;
 	}
 
 	entity->model_index = --model;
@@ -166,37 +183,70 @@ simulation_add_entity(
 }
 
 
+typedef struct simulation_entity_data_ctx
+{
+	simulation_t simulation;
+	simulation_entity_data_t* data;
+}
+simulation_entity_data_ctx_t;
+
+
+private void
+simulation_entity_data_fn(
+	void* data,
+	uint32_t begin,
+	uint32_t end
+	)
+{
+	simulation_entity_data_ctx_t* ctx = data;
+
+	for(uint32_t i = begin; i < end; ++i)
+	{
+		simulation_entity_data_t* cur_data = &ctx->data[i];
+		simulation_entity_t* entity = &ctx->simulation->entities[i];
+
+		cur_data->model_index = entity->model_index;
+
+		glm_mat4_identity(cur_data->transform);
+		glm_translate(cur_data->transform, entity->translation);
+		glm_rotate_x(cur_data->transform, entity->rotation[0], cur_data->transform);
+		glm_rotate_y(cur_data->transform, entity->rotation[1], cur_data->transform);
+		glm_rotate_z(cur_data->transform, entity->rotation[2], cur_data->transform);
+	}
+}
+
+
 simulation_entity_data_t*
 simulation_get_entity_data(
 	simulation_t simulation,
+	alloc_arena_t* arena,
 	uint32_t* data_count
 	)
 {
 	assert_not_null(simulation);
+	assert_not_null(arena);
 
 	if(data_count)
 	{
-		*data_count = simulation->entity_count;
+		*data_count = simulation->entities_vec.count;
 	}
 
-	simulation_entity_data_t* data = alloc_malloc(
-		sizeof(*data) * simulation->entity_count
+	simulation_entity_data_t* data = alloc_arena_alloc(
+		arena,
+		sizeof(*data) * simulation->entities_vec.count,
+		alignof(simulation_entity_data_t),
+		0
 		);
-	assert_not_null(data);
+	assert_ptr(data, simulation->entities_vec.count);
 
-	for(uint32_t i = 0; i < simulation->entity_count; ++i)
+	simulation_entity_data_ctx_t ctx =
 	{
-		simulation_entity_data_t* cur_data = &data[i];
-		simulation_entity_t* entity = &simulation->entities[i];
-
-		cur_data->model_index = entity->model_index;
+		.simulation = simulation,
+		.data = data
+	};
 
-		glm_mat4_identity(cur_data->transform);
-		glm_translate(cur_data->transform, entity->translation);
-		glm_rotate_x(cur_data->transform, entity->rotation[0], cur_data->transform);
-		glm_rotate_y(cur_data->transform, entity->rotation[1], cur_data->transform);
-		glm_rotate_z(cur_data->transform, entity->rotation[2], cur_data->transform);
-	}
+	thread_parallel_for(&simulation->sched, simulation->entities_vec.count,
+		0, THREAD_FOR_FLAG_CALLER_RUNS, simulation_entity_data_fn, &ctx);
 
 	return data;
 }
@@ -212,13 +262,41 @@ simulation_get_models(
 
 	if(model_count)
 	{
-		*model_count = simulation->model_count;
+		*model_count = simulation->models_vec.count;
 	}
 
 	return simulation->models;
 }
 
 
+simulation_camera_t
+simulation_get_camera(
+	simulation_t simulation
+	)
+{
+	assert_not_null(simulation);
+
+	simulation_camera_t camera;
+	sync_seqlock_read(&simulation->camera_lock,
+		&camera, &simulation->camera, sizeof(camera));
+
+	return camera;
+}
+
+
+void
+simulation_set_camera(
+	simulation_t simulation,
+	simulation_camera_t camera
+	)
+{
+	assert_not_null(simulation);
+
+	sync_seqlock_write(&simulation->camera_lock,
+		&simulation->camera, &camera, sizeof(camera));
+}
+
+
 void
 simulation_stop(
 	simulation_t simulation
@@ -16,76 +16,298 @@
 
 #include <thesis/sync.h>
 #include <thesis/debug.h>
+#include <thesis/macro.h>
+#include <thesis/alloc_ext.h>
 
 #include <errno.h>
+#include <sched.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include <stdatomic.h>
 
+#ifndef SYNC_MTX_SPIN_COUNT
+	#define SYNC_MTX_SPIN_COUNT 100
+#endif
 
-void
-sync_mtx_init(
-	sync_mtx_t* mtx
-	)
-{
-	assert_not_null(mtx);
+#ifndef SYNC_RCU_DEFER_COUNT
+	#define SYNC_RCU_DEFER_COUNT 64
+#endif
 
-	int status = pthread_mutex_init(mtx, NULL);
-	hard_assert_eq(status, 0);
-}
+#define SYNC_RCU_CACHE_LINE 64
+#define SYNC_RCU_SPIN_COUNT 128
 
 
 void
-sync_mtx_free(
-	sync_mtx_t* mtx
+sync_pause(
+	void
 	)
 {
-	assert_not_null(mtx);
-
-	int status = pthread_mutex_destroy(mtx);
-	hard_assert_eq(status, 0);
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ volatile("yield");
+#endif
 }
 
 
-void
-sync_mtx_lock(
-	sync_mtx_t* mtx
-	)
-{
-	assert_not_null(mtx);
+#if SYNC_FUTEX
+	#include <limits.h>
+	#include <linux/futex.h>
+	#include <sys/syscall.h>
 
-	int status = pthread_mutex_lock(mtx);
-	assert_eq(status, 0);
-}
+
+	private void
+	sync_futex_wait(
+		uint32_t _Atomic* addr,
+		uint32_t value
+		)
+	{
+		long status = syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+		if(status == -1)
+		{
+			assert_true(errno == EAGAIN || errno == EINTR);
+		}
+	}
 
 
-bool
-sync_mtx_try_lock(
-	sync_mtx_t* mtx
-	)
-{
-	assert_not_null(mtx);
+	private int
+	sync_cancel_begin(
+		void
+		)
+	{
+		int type;
+		int status = pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, &type);
+		assert_eq(status, 0);
 
-	int status = pthread_mutex_trylock(mtx);
-	if(status == 0)
+		return type;
+	}
+
+
+	private void
+	sync_cancel_end(
+		int type
+		)
+	{
+		int status = pthread_setcanceltype(type, NULL);
+		assert_eq(status, 0);
+	}
+
+
+	private void
+	sync_futex_wait_cancel(
+		uint32_t _Atomic* addr,
+		uint32_t value
+		)
+	{
+		/* Raw futex waits are not cancellation points on their own */
+		int type = sync_cancel_begin();
+			sync_futex_wait(addr, value);
+		sync_cancel_end(type);
+	}
+
+
+	private bool
+	sync_futex_timed_wait(
+		uint32_t _Atomic* addr,
+		uint32_t value,
+		uint64_t ns
+		)
 	{
+		struct timespec time;
+		time.tv_sec = ns / 1000000000;
+		time.tv_nsec = ns % 1000000000;
+
+		int type = sync_cancel_begin();
+			long status = syscall(SYS_futex, addr,
+				FUTEX_WAIT_BITSET_PRIVATE | FUTEX_CLOCK_REALTIME,
+				value, &time, NULL, FUTEX_BITSET_MATCH_ANY);
+			int error = errno;
+		sync_cancel_end(type);
+
+		if(status == -1)
+		{
+			if(error == ETIMEDOUT)
+			{
+				return false;
+			}
+
+			assert_true(error == EAGAIN || error == EINTR);
+		}
+
 		return true;
 	}
 
-	assert_eq(status, EBUSY);
-	return false;
-}
 
+	private void
+	sync_futex_wake(
+		uint32_t _Atomic* addr,
+		uint32_t count
+		)
+	{
+		long status = syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE,
+			MACRO_MIN(count, (uint32_t) INT_MAX), NULL, NULL, 0);
+		assert_neq(status, -1);
+	}
 
-void
-sync_mtx_unlock(
-	sync_mtx_t* mtx
-	)
-{
-	assert_not_null(mtx);
 
-	int status = pthread_mutex_unlock(mtx);
-	assert_eq(status, 0);
-}
+	void
+	sync_mtx_init(
+		sync_mtx_t* mtx
+		)
+	{
+		assert_not_null(mtx);
+
+		atomic_init(&mtx->state, 0);
+	}
+
+
+	void
+	sync_mtx_free(
+		sync_mtx_t* mtx
+		)
+	{
+		assert_not_null(mtx);
+		assert_eq(atomic_load_explicit(&mtx->state, memory_order_relaxed), 0);
+	}
+
+
+	void
+	sync_mtx_lock(
+		sync_mtx_t* mtx
+		)
+	{
+		assert_not_null(mtx);
+
+		uint32_t state = 0;
+		if(atomic_compare_exchange_strong_explicit(&mtx->state, &state, 1,
+			memory_order_acquire, memory_order_relaxed))
+		{
+			return;
+		}
+
+		for(uint32_t i = 0; i < SYNC_MTX_SPIN_COUNT && state != 2; ++i)
+		{
+			sync_pause();
+
+			state = atomic_load_explicit(&mtx->state, memory_order_relaxed);
+			if(state == 0 && atomic_compare_exchange_weak_explicit(&mtx->state, &state, 1,
+				memory_order_acquire, memory_order_relaxed))
+			{
+				return;
+			}
+		}
+
+		if(state != 2)
+		{
+			state = atomic_exchange_explicit(&mtx->state, 2, memory_order_acquire);
+		}
+
+		while(state != 0)
+		{
+			sync_futex_wait(&mtx->state, 2);
+			state = atomic_exchange_explicit(&mtx->state, 2, memory_order_acquire);
+		}
+	}
+
+
+	bool
+	sync_mtx_try_lock(
+		sync_mtx_t* mtx
+		)
+	{
+		assert_not_null(mtx);
+
+		uint32_t state = 0;
+		return atomic_compare_exchange_strong_explicit(&mtx->state, &state, 1,
+			memory_order_acquire, memory_order_relaxed);
+	}
+
+
+	void
+	sync_mtx_unlock(
+		sync_mtx_t* mtx
+		)
+	{
+		assert_not_null(mtx);
+
+		uint32_t state = atomic_fetch_sub_explicit(&mtx->state, 1, memory_order_release);
+		assert_neq(state, 0);
+
+		if(state != 1)
+		{
+			atomic_store_explicit(&mtx->state, 0, memory_order_release);
+			sync_futex_wake(&mtx->state, 1);
+		}
+	}
+
+
+#else
+	void
+	sync_mtx_init(
+		sync_mtx_t* mtx
+		)
+	{
+		assert_not_null(mtx);
+
+		int status = pthread_mutex_init(mtx, NULL);
+		hard_assert_eq(status, 0);
+	}
+
+
+	void
+	sync_mtx_free(
+		sync_mtx_t* mtx
+		)
+	{
+		assert_not_null(mtx);
+
+		int status = pthread_mutex_destroy(mtx);
+		hard_assert_eq(status, 0);
+	}
+
+
+	void
+	sync_mtx_lock(
+		sync_mtx_t* mtx
+		)
+	{
+		assert_not_null(mtx);
+
+		int status = pthread_mutex_lock(mtx);
+		assert_eq(status, 0);
+	}
+
+
+	bool
+	sync_mtx_try_lock(
+		sync_mtx_t* mtx
+		)
+	{
+		assert_not_null(mtx);
+
+		int status = pthread_mutex_trylock(mtx);
+		if(status == 0)
+		{
+			return true;
+		}
+
+		assert_eq(status, EBUSY);
+		return false;
+	}
+
+
+	void
+	sync_mtx_unlock(
+		sync_mtx_t* mtx
+		)
+	{
+		assert_not_null(mtx);
+
+		int status = pthread_mutex_unlock(mtx);
+		assert_eq(status, 0);
+	}
+#endif
 
 
 void
@@ -184,140 +406,1121 @@ sync_rwlock_unlock(
 }
 
 
-void
-sync_cond_init(
-	sync_cond_t* cond
-	)
-{
-	assert_not_null(cond);
+#if SYNC_FUTEX
+	void
+	sync_cond_init(
+		sync_cond_t* cond
+		)
+	{
+		assert_not_null(cond);
 
-	int status = pthread_cond_init(cond, NULL);
-	hard_assert_eq(status, 0);
-}
+		atomic_init(&cond->seq, 0);
+	}
 
 
-void
-sync_cond_free(
-	sync_cond_t* cond
-	)
-{
-	assert_not_null(cond);
+	void
+	sync_cond_free(
+		sync_cond_t* cond
+		)
+	{
+		assert_not_null(cond);
+	}
 
-	int status = pthread_cond_destroy(cond);
-	hard_assert_eq(status, 0);
-}
 
+	void
+	sync_cond_wait(
+		sync_cond_t* cond,
+		sync_mtx_t* mtx
+		)
+	{
+		assert_not_null(cond);
+		assert_not_null(mtx);
 
-void
-sync_cond_wait(
-	sync_cond_t* cond,
-	sync_mtx_t* mtx
-	)
-{
-	assert_not_null(cond);
-	assert_not_null(mtx);
+		uint32_t seq = atomic_load_explicit(&cond->seq, memory_order_relaxed);
 
-	int status = pthread_cond_wait(cond, mtx);
-	assert_eq(status, 0);
-}
+		sync_mtx_unlock(mtx);
 
+		pthread_cleanup_push((void*) sync_mtx_lock, mtx);
+			sync_futex_wait_cancel(&cond->seq, seq);
+		pthread_cleanup_pop(1);
+	}
 
-void
-sync_cond_wake(
-	sync_cond_t* cond
-	)
-{
-	assert_not_null(cond);
 
-	int status = pthread_cond_signal(cond);
-	assert_eq(status, 0);
-}
+	void
+	sync_cond_wake(
+		sync_cond_t* cond
+		)
+	{
+		assert_not_null(cond);
 
+		atomic_fetch_add_explicit(&cond->seq, 1, memory_order_release);
+		sync_futex_wake(&cond->seq, 1);
+	}
 
-void
-sync_sem_init(
-	sync_sem_t* sem,
-	uint32_t value
-	)
-{
-	assert_not_null(sem);
 
-	int status = sem_init(sem, 0, value);
-	hard_assert_eq(status, 0);
-}
+	void
+	sync_cond_wake_all(
+		sync_cond_t* cond
+		)
+	{
+		assert_not_null(cond);
 
+		atomic_fetch_add_explicit(&cond->seq, 1, memory_order_release);
+		sync_futex_wake(&cond->seq, UINT32_MAX);
+	}
 
-void
-sync_sem_free(
-	sync_sem_t* sem
-	)
-{
-	assert_not_null(sem);
 
-	int status = sem_destroy(sem);
-	hard_assert_eq(status, 0);
-}
+#else
+	void
+	sync_cond_init(
+		sync_cond_t* cond
+		)
+	{
+		assert_not_null(cond);
 
+		int status = pthread_cond_init(cond, NULL);
+		hard_assert_eq(status, 0);
+	}
 
-void
-sync_sem_wait(
-	sync_sem_t* sem
-	)
-{
-	assert_not_null(sem);
 
-	int status;
-	while((status = sem_wait(sem)))
+	void
+	sync_cond_free(
+		sync_cond_t* cond
+		)
+	{
+		assert_not_null(cond);
+
+		int status = pthread_cond_destroy(cond);
+		hard_assert_eq(status, 0);
+	}
+
+
+	void
+	sync_cond_wait(
+		sync_cond_t* cond,
+		sync_mtx_t* mtx
+		)
+	{
+		assert_not_null(cond);
+		assert_not_null(mtx);
+
+		int status = pthread_cond_wait(cond, mtx);
+		assert_eq(status, 0);
+	}
+
+
+	void
+	sync_cond_wake(
+		sync_cond_t* cond
+		)
+	{
+		assert_not_null(cond);
+
+		int status = pthread_cond_signal(cond);
+		assert_eq(status, 0);
+	}
+
+
+	void
+	sync_cond_wake_all(
+		sync_cond_t* cond
+		)
+	{
+		assert_not_null(cond);
+
+		int status = pthread_cond_broadcast(cond);
+		assert_eq(status, 0);
+	}
+#endif
+
+
+#if SYNC_FUTEX
+	void
+	sync_sem_init(
+		sync_sem_t* sem,
+		uint32_t value
+		)
 	{
-		if(errno == EINTR)
+		assert_not_null(sem);
+
+		atomic_init(&sem->value, value);
+		atomic_init(&sem->waiters, 0);
+	}
+
+
+	void
+	sync_sem_free(
+		sync_sem_t* sem
+		)
+	{
+		assert_not_null(sem);
+	}
+
+
+	bool
+	sync_sem_try_wait(
+		sync_sem_t* sem
+		)
+	{
+		assert_not_null(sem);
+
+		uint32_t value = atomic_load_explicit(&sem->value, memory_order_relaxed);
+
+		while(value)
 		{
-			continue;
+			if(atomic_compare_exchange_weak_explicit(&sem->value, &value, value - 1,
+				memory_order_acquire, memory_order_relaxed))
+			{
+				return true;
+			}
 		}
 
-		fprintf(stderr, "sem_wait: %s\n", strerror(errno));
-		hard_assert_unreachable();
+		return false;
 	}
-}
 
 
-void
-sync_sem_timed_wait(
-	sync_sem_t* sem,
-	uint64_t ns
-	)
-{
-	assert_not_null(sem);
+	private void
+	sync_sem_leave(
+		sync_sem_t* sem
+		)
+	{
+		atomic_fetch_sub_explicit(&sem->waiters, 1, memory_order_relaxed);
+	}
 
-	struct timespec time;
-	time.tv_sec = ns / 1000000000;
-	time.tv_nsec = ns % 1000000000;
 
-	int status;
-	while((status = sem_timedwait(sem, &time)))
+	void
+	sync_sem_wait(
+		sync_sem_t* sem
+		)
 	{
-		if(errno == EINTR)
+		assert_not_null(sem);
+
+		while(!sync_sem_try_wait(sem))
 		{
-			continue;
+			atomic_fetch_add_explicit(&sem->waiters, 1, memory_order_seq_cst);
+
+			pthread_cleanup_push((void*) sync_sem_leave, sem);
+				sync_futex_wait_cancel(&sem->value, 0);
+			pthread_cleanup_pop(1);
 		}
+	}
 
-		if(errno == ETIMEDOUT)
+
+	void
+	sync_sem_timed_wait(
+		sync_sem_t* sem,
+		uint64_t ns
+		)
+	{
+		assert_not_null(sem);
+
+		while(!sync_sem_try_wait(sem))
 		{
-			break;
+			atomic_fetch_add_explicit(&sem->waiters, 1, memory_order_seq_cst);
+
+			bool status;
+
+			pthread_cleanup_push((void*) sync_sem_leave, sem);
+				status = sync_futex_timed_wait(&sem->value, 0, ns);
+			pthread_cleanup_pop(1);
+
+			if(!status)
+			{
+				(void) sync_sem_try_wait(sem);
+				break;
+			}
 		}
+	}
 
-		fprintf(stderr, "sem_timedwait: %s\n", strerror(errno));
-		hard_assert_unreachable();
+
+	void
+	sync_sem_post(
+		sync_sem_t* sem
+		)
+	{
+		sync_sem_post_n(sem, 1);
 	}
-}
 
 
-void
-sync_sem_post(
-	sync_sem_t* sem
-	)
-{
-	assert_not_null(sem);
+	void
+	sync_sem_post_n(
+		sync_sem_t* sem,
+		uint32_t count
+		)
+	{
+		assert_not_null(sem);
 
-	int status = sem_post(sem);
-	assert_eq(status, 0);
+		if(!count)
+		{
+			return;
+		}
+
+		atomic_fetch_add_explicit(&sem->value, count, memory_order_seq_cst);
+
+		if(atomic_load_explicit(&sem->waiters, memory_order_seq_cst))
+		{
+			sync_futex_wake(&sem->value, count);
+		}
+	}
+
+
+#else
+	void
+	sync_sem_init(
+		sync_sem_t* sem,
+		uint32_t value
+		)
+	{
+		assert_not_null(sem);
+
+		int status = sem_init(sem, 0, value);
+		hard_assert_eq(status, 0);
+	}
+
+
+	void
+	sync_sem_free(
+		sync_sem_t* sem
+		)
+	{
+		assert_not_null(sem);
+
+		int status = sem_destroy(sem);
+		hard_assert_eq(status, 0);
+	}
+
+
+	void
+	sync_sem_wait(
+		sync_sem_t* sem
+		)
+	{
+		assert_not_null(sem);
+
+		int status;
+		while((status = sem_wait(sem)))
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+
+			fprintf(stderr, "sem_wait: %s\n", strerror(errno));
+			hard_assert_unreachable();
+		}
+	}
+
+
+	bool
+	sync_sem_try_wait(
+		sync_sem_t* sem
+		)
+	{
+		assert_not_null(sem);
+
+		int status;
+		while((status = sem_trywait(sem)))
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+
+			if(errno == EAGAIN)
+			{
+				return false;
+			}
+
+			fprintf(stderr, "sem_trywait: %s\n", strerror(errno));
+			hard_assert_unreachable();
+		}
+
+		return true;
+	}
+
+
+	void
+	sync_sem_timed_wait(
+		sync_sem_t* sem,
+		uint64_t ns
+		)
+	{
+		assert_not_null(sem);
+
+		struct timespec time;
+		time.tv_sec = ns / 1000000000;
+		time.tv_nsec = ns % 1000000000;
+
+		int status;
+		while((status = sem_timedwait(sem, &time)))
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+
+			if(errno == ETIMEDOUT)
+			{
+				break;
+			}
+
+			fprintf(stderr, "sem_timedwait: %s\n", strerror(errno));
+			hard_assert_unreachable();
+		}
+	}
+
+
+	void
+	sync_sem_post(
+		sync_sem_t* sem
+		)
+	{
+		assert_not_null(sem);
+
+		int status = sem_post(sem);
+		assert_eq(status, 0);
+	}
+
+
+	void
+	sync_sem_post_n(
+		sync_sem_t* sem,
+		uint32_t count
+		)
+	{
+		assert_not_null(sem);
+
+		while(count--)
+		{
+			int status = sem_post(sem);
+			assert_eq(status, 0);
+		}
+	}
+#endif
+
+
+#if SYNC_FUTEX
+	void
+	sync_event_init(
+		sync_event_t* event
+		)
+	{
+		assert_not_null(event);
+
+		atomic_init(&event->state, 0);
+	}
+
+
+	void
+	sync_event_free(
+		sync_event_t* event
+		)
+	{
+		assert_not_null(event);
+	}
+
+
+	void
+	sync_event_set(
+		sync_event_t* event
+		)
+	{
+		assert_not_null(event);
+
+		if(atomic_exchange_explicit(&event->state, 1, memory_order_release) == 2)
+		{
+			sync_futex_wake(&event->state, UINT32_MAX);
+		}
+	}
+
+
+	void
+	sync_event_reset(
+		sync_event_t* event
+		)
+	{
+		assert_not_null(event);
+
+		uint32_t state = 1;
+		(void) atomic_compare_exchange_strong_explicit(&event->state, &state, 0,
+			memory_order_relaxed, memory_order_relaxed);
+	}
+
+
+	bool
+	sync_event_is_set(
+		sync_event_t* event
+		)
+	{
+		assert_not_null(event);
+
+		return atomic_load_explicit(&event->state, memory_order_acquire) == 1;
+	}
+
+
+	void
+	sync_event_wait(
+		sync_event_t* event
+		)
+	{
+		assert_not_null(event);
+
+		while(1)
+		{
+			uint32_t state = atomic_load_explicit(&event->state, memory_order_acquire);
+			if(state == 1)
+			{
+				return;
+			}
+
+			if(state == 0 && !atomic_compare_exchange_weak_explicit(&event->state,
+				&state, 2, memory_order_relaxed, memory_order_relaxed))
+			{
+				continue;
+			}
+
+			sync_futex_wait_cancel(&event->state, 2);
+		}
+	}
+
+
+	void
+	sync_latch_init(
+		sync_latch_t* latch,
+		uint32_t count
+		)
+	{
+		assert_not_null(latch);
+
+		atomic_init(&latch->count, count);
+	}
+
+
+	void
+	sync_latch_free(
+		sync_latch_t* latch
+		)
+	{
+		assert_not_null(latch);
+	}
+
+
+	void
+	sync_latch_count_down(
+		sync_latch_t* latch,
+		uint32_t count
+		)
+	{
+		assert_not_null(latch);
+
+		uint32_t value = atomic_fetch_sub_explicit(&latch->count, count, memory_order_acq_rel);
+		assert_ge(value, count);
+
+		if(value == count)
+		{
+			sync_futex_wake(&latch->count, UINT32_MAX);
+		}
+	}
+
+
+	bool
+	sync_latch_try_wait(
+		sync_latch_t* latch
+		)
+	{
+		assert_not_null(latch);
+
+		return !atomic_load_explicit(&latch->count, memory_order_acquire);
+	}
+
+
+	void
+	sync_latch_wait(
+		sync_latch_t* latch
+		)
+	{
+		assert_not_null(latch);
+
+		uint32_t value;
+		while((value = atomic_load_explicit(&latch->count, memory_order_acquire)))
+		{
+			sync_futex_wait_cancel(&latch->count, value);
+		}
+	}
+
+
+#else
+	void
+	sync_event_init(
+		sync_event_t* event
+		)
+	{
+		assert_not_null(event);
+
+		sync_mtx_init(&event->mtx);
+		sync_cond_init(&event->cond);
+
+		event->state = 0;
+	}
+
+
+	void
+	sync_event_free(
+		sync_event_t* event
+		)
+	{
+		assert_not_null(event);
+
+		sync_cond_free(&event->cond);
+		sync_mtx_free(&event->mtx);
+	}
+
+
+	void
+	sync_event_set(
+		sync_event_t* event
+		)
+	{
+		assert_not_null(event);
+
+		sync_mtx_lock(&event->mtx);
+			event->state = 1;
+			sync_cond_wake_all(&event->cond);
+		sync_mtx_unlock(&event->mtx);
+	}
+
+
+	void
+	sync_event_reset(
+		sync_event_t* event
+		)
+	{
+		assert_not_null(event);
+
+		sync_mtx_lock(&event->mtx);
+			event->state = 0;
+		sync_mtx_unlock(&event->mtx);
+	}
+
+
+	bool
+	sync_event_is_set(
+		sync_event_t* event
+		)
+	{
+		assert_not_null(event);
+
+		sync_mtx_lock(&event->mtx);
+			bool status = event->state;
+		sync_mtx_unlock(&event->mtx);
+
+		return status;
+	}
+
+
+	void
+	sync_event_wait(
+		sync_event_t* event
+		)
+	{
+		assert_not_null(event);
+
+		sync_mtx_lock(&event->mtx);
+			pthread_cleanup_push((void*) sync_mtx_unlock, &event->mtx);
+				while(!event->state)
+				{
+					sync_cond_wait(&event->cond, &event->mtx);
+				}
+			pthread_cleanup_pop(0);
+		sync_mtx_unlock(&event->mtx);
+	}
+
+
+	void
+	sync_latch_init(
+		sync_latch_t* latch,
+		uint32_t count
+		)
+	{
+		assert_not_null(latch);
+
+		sync_mtx_init(&latch->mtx);
+		sync_cond_init(&latch->cond);
+
+		latch->count = count;
+	}
+
+
+	void
+	sync_latch_free(
+		sync_latch_t* latch
+		)
+	{
+		assert_not_null(latch);
+
+		sync_cond_free(&latch->cond);
+		sync_mtx_free(&latch->mtx);
+	}
+
+
+	void
+	sync_latch_count_down(
+		sync_latch_t* latch,
+		uint32_t count
+		)
+	{
+		assert_not_null(latch);
+
+		sync_mtx_lock(&latch->mtx);
+			assert_ge(latch->count, count);
+			latch->count -= count;
+
+			if(!latch->count)
+			{
+				sync_cond_wake_all(&latch->cond);
+			}
+		sync_mtx_unlock(&latch->mtx);
+	}
+
+
+	bool
+	sync_latch_try_wait(
+		sync_latch_t* latch
+		)
+	{
+		assert_not_null(latch);
+
+		sync_mtx_lock(&latch->mtx);
+			bool status = !latch->count;
+		sync_mtx_unlock(&latch->mtx);
+
+		return status;
+	}
+
+
+	void
+	sync_latch_wait(
+		sync_latch_t* latch
+		)
+	{
+		assert_not_null(latch);
+
+		sync_mtx_lock(&latch->mtx);
+			pthread_cleanup_push((void*) sync_mtx_unlock, &latch->mtx);
+				while(latch->count)
+				{
+					sync_cond_wait(&latch->cond, &latch->mtx);
+				}
+			pthread_cleanup_pop(0);
+		sync_mtx_unlock(&latch->mtx);
+	}
+#endif
+
+
+void
+sync_seqlock_init(
+	sync_seqlock_t* lock
+	)
+{
+	assert_not_null(lock);
+
+	atomic_init(&lock->seq, 0);
+}
+
+
+void
+sync_seqlock_free(
+	sync_seqlock_t* lock
+	)
+{
+	assert_not_null(lock);
+	assert_false(atomic_load_explicit(&lock->seq, memory_order_relaxed) & 1);
+}
+
+
+void
+sync_seqlock_write_lock(
+	sync_seqlock_t* lock
+	)
+{
+	assert_not_null(lock);
+
+	uint32_t seq = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+
+	while((seq & 1) || !atomic_compare_exchange_weak_explicit(&lock->seq, &seq,
+		seq + 1, memory_order_acquire, memory_order_relaxed))
+	{
+		sync_pause();
+		seq = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+	}
+
+	atomic_thread_fence(memory_order_release);
+}
+
+
+void
+sync_seqlock_write_unlock(
+	sync_seqlock_t* lock
+	)
+{
+	assert_not_null(lock);
+
+	uint32_t seq = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+	assert_true(seq & 1);
+
+	atomic_store_explicit(&lock->seq, seq + 1, memory_order_release);
+}
+
+
+uint32_t
+sync_seqlock_read_begin(
+	sync_seqlock_t* lock
+	)
+{
+	assert_not_null(lock);
+
+	uint32_t seq;
+	while((seq = atomic_load_explicit(&lock->seq, memory_order_acquire)) & 1)
+	{
+		sync_pause();
+	}
+
+	return seq;
+}
+
+
+bool
+sync_seqlock_read_retry(
+	sync_seqlock_t* lock,
+	uint32_t seq
+	)
+{
+	assert_not_null(lock);
+
+	atomic_thread_fence(memory_order_acquire);
+
+	return atomic_load_explicit(&lock->seq, memory_order_relaxed) != seq;
+}
+
+
+void
+sync_seqlock_read(
+	sync_seqlock_t* lock,
+	void* dst,
+	const void* src,
+	size_t size
+	)
+{
+	assert_ptr(dst, size);
+	assert_ptr(src, size);
+
+	uint32_t seq;
+
+	do
+	{
+		seq = sync_seqlock_read_begin(lock);
+		(void) memcpy(dst, src, size);
+	}
+	while(sync_seqlock_read_retry(lock, seq));
+}
+
+
+void
+sync_seqlock_write(
+	sync_seqlock_t* lock,
+	void* dst,
+	const void* src,
+	size_t size
+	)
+{
+	assert_ptr(dst, size);
+	assert_ptr(src, size);
+
+	sync_seqlock_write_lock(lock);
+		(void) memcpy(dst, src, size);
+	sync_seqlock_write_unlock(lock);
+}
+
+
+typedef struct sync_rcu_reader sync_rcu_reader_t;
+
+struct sync_rcu_reader
+{
+	_Alignas(SYNC_RCU_CACHE_LINE) uint64_t _Atomic epoch;
+	uint32_t nesting;
+	bool _Atomic active;
+	sync_rcu_reader_t* next;
+};
+
+
+typedef struct sync_rcu_deferred
+{
+	sync_rcu_fn_t fn;
+	void* data;
+	size_t size;
+}
+sync_rcu_deferred_t;
+
+
+private uint64_t _Atomic sync_rcu_epoch = 1;
+private sync_rcu_reader_t* _Atomic sync_rcu_readers;
+private _Thread_local sync_rcu_reader_t* sync_rcu_reader;
+
+private pthread_key_t sync_rcu_key;
+private pthread_once_t sync_rcu_once = PTHREAD_ONCE_INIT;
+
+private sync_mtx_t sync_rcu_mtx = SYNC_MTX_INIT;
+private sync_rcu_deferred_t sync_rcu_deferred[SYNC_RCU_DEFER_COUNT];
+private uint32_t sync_rcu_deferred_count;
+
+
+private void
+sync_rcu_key_fn(
+	void* data
+	)
+{
+	sync_rcu_reader_t* reader = data;
+
+	assert_eq(reader->nesting, 0);
+	atomic_store_explicit(&reader->active, false, memory_order_release);
+}
+
+
+private void
+sync_rcu_once_fn(
+	void
+	)
+{
+	int status = pthread_key_create(&sync_rcu_key, sync_rcu_key_fn);
+	hard_assert_eq(status, 0);
+}
+
+
+private sync_rcu_reader_t*
+sync_rcu_get_reader(
+	void
+	)
+{
+	sync_rcu_reader_t* reader = sync_rcu_reader;
+	if(reader)
+	{
+		return reader;
+	}
+
+	int status = pthread_once(&sync_rcu_once, sync_rcu_once_fn);
+	hard_assert_eq(status, 0);
+
+	reader = atomic_load_explicit(&sync_rcu_readers, memory_order_acquire);
+
+	for(; reader; reader = reader->next)
+	{
+		bool active = false;
+		if(atomic_compare_exchange_strong_explicit(&reader->active, &active, true,
+			memory_order_acquire, memory_order_relaxed))
+		{
+			break;
+		}
+	}
+
+	if(!reader)
+	{
+		reader = alloc_malloc(sizeof(*reader));
+		assert_not_null(reader);
+
+		atomic_init(&reader->epoch, 0);
+		atomic_init(&reader->active, true);
+
+		reader->next = atomic_load_explicit(&sync_rcu_readers, memory_order_relaxed);
+
+		while(!atomic_compare_exchange_weak_explicit(&sync_rcu_readers, &reader->next,
+			reader, memory_order_release, memory_order_relaxed));
+	}
+
+	reader->nesting = 0;
+
+	status = pthread_setspecific(sync_rcu_key, reader);
+	hard_assert_eq(status, 0);
+
+	sync_rcu_reader = reader;
+
+	return reader;
+}
+
+
+void
+sync_rcu_read_lock(
+	void
+	)
+{
+	sync_rcu_reader_t* reader = sync_rcu_get_reader();
+
+	if(!reader->nesting++)
+	{
+		uint64_t epoch = atomic_load_explicit(&sync_rcu_epoch, memory_order_relaxed);
+		atomic_store_explicit(&reader->epoch, epoch, memory_order_relaxed);
+
+		atomic_thread_fence(memory_order_seq_cst);
+	}
+}
+
+
+void
+sync_rcu_read_unlock(
+	void
+	)
+{
+	sync_rcu_reader_t* reader = sync_rcu_reader;
+	assert_not_null(reader);
+	assert_gt(reader->nesting, 0);
+
+	if(!--reader->nesting)
+	{
+		atomic_store_explicit(&reader->epoch, 0, memory_order_release);
+	}
+}
+
+
+void
+sync_rcu_synchronize(
+	void
+	)
+{
+	assert_true(!sync_rcu_reader || !sync_rcu_reader->nesting);
+
+	uint64_t epoch = atomic_fetch_add_explicit(&sync_rcu_epoch, 1, memory_order_seq_cst) + 1;
+
+	sync_rcu_reader_t* reader = atomic_load_explicit(&sync_rcu_readers, memory_order_acquire);
+
+	for(; reader; reader = reader->next)
+	{
+		uint32_t spins = 0;
+
+		while(1)
+		{
+			uint64_t reader_epoch = atomic_load_explicit(&reader->epoch, memory_order_acquire);
+			if(!reader_epoch || reader_epoch >= epoch)
+			{
+				break;
+			}
+
+			if(++spins < SYNC_RCU_SPIN_COUNT)
+			{
+				sync_pause();
+			}
+			else
+			{
+				(void) sched_yield();
+			}
+		}
+	}
+}
+
+
+private void
+sync_rcu_run(
+	sync_rcu_deferred_t* deferred,
+	uint32_t count
+	)
+{
+	if(!count)
+	{
+		return;
+	}
+
+	sync_rcu_synchronize();
+
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		if(deferred[i].fn)
+		{
+			deferred[i].fn(deferred[i].data);
+		}
+		else
+		{
+			alloc_free(deferred[i].data, deferred[i].size);
+		}
+	}
+}
+
+
+private void
+sync_rcu_defer(
+	sync_rcu_deferred_t entry
+	)
+{
+	sync_rcu_deferred_t deferred[SYNC_RCU_DEFER_COUNT];
+	uint32_t count = 0;
+
+	sync_mtx_lock(&sync_rcu_mtx);
+		if(sync_rcu_deferred_count == SYNC_RCU_DEFER_COUNT)
+		{
+			count = sync_rcu_deferred_count;
+			(void) memcpy(deferred, sync_rcu_deferred, sizeof(*deferred) * count);
+
+			sync_rcu_deferred_count = 0;
+		}
+
+		sync_rcu_deferred[sync_rcu_deferred_count++] = entry;
+	sync_mtx_unlock(&sync_rcu_mtx);
+
+	sync_rcu_run(deferred, count);
+}
+
+
+void
+sync_rcu_call(
+	sync_rcu_fn_t fn,
+	void* data
+	)
+{
+	assert_not_null(fn);
+
+	sync_rcu_defer(
+		(sync_rcu_deferred_t)
+		{
+			.fn = fn,
+			.data = data
+		}
+		);
+}
+
+
+void
+sync_rcu_free(
+	void* ptr,
+	size_t size
+	)
+{
+	assert_ptr(ptr, size);
+
+	if(!ptr)
+	{
+		return;
+	}
+
+	sync_rcu_defer(
+		(sync_rcu_deferred_t)
+		{
+			.data = ptr,
+			.size = size
+		}
+		);
+}
+
+
+void
+sync_rcu_barrier(
+	void
+	)
+{
+	sync_rcu_deferred_t deferred[SYNC_RCU_DEFER_COUNT];
+
+	sync_mtx_lock(&sync_rcu_mtx);
+		uint32_t count = sync_rcu_deferred_count;
+		(void) memcpy(deferred, sync_rcu_deferred, sizeof(*deferred) * count);
+
+		sync_rcu_deferred_count = 0;
+	sync_mtx_unlock(&sync_rcu_mtx);
+
+	sync_rcu_run(deferred, count);
 }
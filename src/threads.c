@@ -18,8 +18,49 @@
 #include <thesis/threads.h>
 #include <thesis/alloc_ext.h>
 
+#include <time.h>
+#include <stdio.h>
+#include <sched.h>
+#include <assert.h>
 #include <errno.h>
 #include <string.h>
+#include <unistd.h>
+#include <stdatomic.h>
+
+
+#define THREADS_MAX_COUNT MACRO_POWER_OF_2(16)
+#define THREAD_POOL_MAX_COUNT MACRO_POWER_OF_2(24)
+#define THREAD_POOL_PRIORITY_MAX_COUNT MACRO_POWER_OF_2(20)
+
+#ifndef THREAD_POOL_RING_SIZE
+	#define THREAD_POOL_RING_SIZE MACRO_POWER_OF_2(12)
+#endif
+
+static_assert((THREAD_POOL_RING_SIZE & (THREAD_POOL_RING_SIZE - 1)) == 0,
+	"THREAD_POOL_RING_SIZE must be a power of 2");
+
+#ifndef THREAD_POOL_STARVATION_PERIOD
+	#define THREAD_POOL_STARVATION_PERIOD 32
+#endif
+
+#ifndef THREAD_SCHED_DEQUE_SIZE
+	#define THREAD_SCHED_DEQUE_SIZE MACRO_POWER_OF_2(12)
+#endif
+
+static_assert((THREAD_SCHED_DEQUE_SIZE & (THREAD_SCHED_DEQUE_SIZE - 1)) == 0,
+	"THREAD_SCHED_DEQUE_SIZE must be a power of 2");
+
+#ifndef THREAD_SPIN_NS
+	#define THREAD_SPIN_NS 20000
+#endif
+
+#define THREAD_SPIN_MAX_PAUSES 64
+#define THREAD_NAME_MAX_LEN 16
+#define THREAD_CACHE_MAX_INDEX 8
+#define THREAD_JOB_MAX_CONTINUATIONS 8
+#define THREAD_FOR_CHUNKS_PER_THREAD 8
+#define THREAD_CACHE_LINE_SIZE 64
+#define THREAD_COUNTER_WAITING MACRO_POWER_OF_2(31)
 
 
 typedef struct thread_init_data
@@ -29,15 +70,35 @@ typedef struct thread_init_data
 thread_init_data_t;
 
 
+private alloc_pool_t thread_init_data_pool =
+	ALLOC_POOL_INIT(thread_init_data_t, ALLOC_POOL_FLAG_NONE);
+
+
+private void
+thread_cleanup_fn(
+	void* data
+	)
+{
+	(void) data;
+
+	alloc_free_thread_arena();
+	alloc_flush_thread_pools();
+	alloc_flush_thread_cache();
+}
+
+
 private void*
 thread_fn(
 	thread_init_data_t* init_data
 	)
 {
 	thread_data_t data = init_data->data;
-	alloc_free(init_data, sizeof(*init_data));
+	alloc_pool_release(&thread_init_data_pool, init_data);
+
+	pthread_cleanup_push(thread_cleanup_fn, NULL);
+		data.fn(data.data);
+	pthread_cleanup_pop(true);
 
-	data.fn(data.data);
 	return NULL;
 }
 
@@ -52,7 +113,7 @@ thread_init(
 
 	thread_t id;
 
-	thread_init_data_t* init_data = alloc_malloc(sizeof(*init_data));
+	thread_init_data_t* init_data = alloc_pool_alloc(&thread_init_data_pool, 0);
 	assert_not_null(init_data);
 
 	init_data->data = data;
@@ -240,27 +301,371 @@ thread_sleep(
 }
 
 
-private void
-threads_resize(
-	threads_t* threads,
+uint32_t
+thread_get_cpu_count(
+	void
+	)
+{
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return count > 0 ? count : 1;
+}
+
+
+private uint64_t _Atomic thread_spin_ns = THREAD_SPIN_NS;
+
+
+void
+thread_set_spin_ns(
+	uint64_t ns
+	)
+{
+	atomic_store_explicit(&thread_spin_ns, ns, memory_order_relaxed);
+}
+
+
+uint64_t
+thread_get_spin_ns(
+	void
+	)
+{
+	return atomic_load_explicit(&thread_spin_ns, memory_order_relaxed);
+}
+
+
+private uint64_t
+thread_get_time(
+	void
+	)
+{
+	struct timespec time;
+	int status = clock_gettime(CLOCK_MONOTONIC, &time);
+	hard_assert_eq(status, 0);
+
+	return time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+
+private bool
+thread_spin(
+	bool (*has_work_fn)(void* data),
+	void* data
+	)
+{
+	uint64_t spin_ns = thread_get_spin_ns();
+	if(!spin_ns)
+	{
+		return false;
+	}
+
+	uint64_t end = thread_get_time() + spin_ns;
+	uint32_t pauses = 1;
+
+	do
+	{
+		for(uint32_t i = 0; i < pauses; ++i)
+		{
+			sync_pause();
+		}
+
+		if(has_work_fn(data))
+		{
+			return true;
+		}
+
+		pauses = MACRO_MIN(pauses << 1, THREAD_SPIN_MAX_PAUSES);
+	}
+	while(thread_get_time() < end);
+
+	return false;
+}
+
+
+void
+thread_set_name(
+	thread_t thread,
+	const char* name
+	)
+{
+	assert_not_null(name);
+
+	char buffer[THREAD_NAME_MAX_LEN];
+	size_t len = strnlen(name, sizeof(buffer) - 1);
+
+	(void) memcpy(buffer, name, len);
+	buffer[len] = 0;
+
+	(void) pthread_setname_np(thread, buffer);
+}
+
+
+bool
+thread_set_affinity(
+	thread_t thread,
+	const uint32_t* cpus,
 	uint32_t count
 	)
 {
-	uint32_t new_used = threads->used + count;
+	assert_not_null(cpus);
+	assert_gt(count, 0);
+
+	uint32_t max = 0;
 
-	if((new_used < (threads->size >> 2)) || (new_used > threads->size))
+	for(uint32_t i = 0; i < count; ++i)
 	{
-		uint32_t new_size = (new_used << 1) | 1;
+		max = MACRO_MAX(max, cpus[i]);
+	}
 
-		threads->threads = alloc_remalloc(
-			threads->threads,
-			sizeof(*threads->threads) * threads->size,
-			sizeof(*threads->threads) * new_size
-			);
-		assert_not_null(threads->threads);
+	cpu_set_t* set = CPU_ALLOC(max + 1);
+	assert_not_null(set);
+
+	size_t size = CPU_ALLOC_SIZE(max + 1);
+	CPU_ZERO_S(size, set);
+
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		CPU_SET_S(cpus[i], size, set);
+	}
+
+	int status = pthread_setaffinity_np(thread, size, set);
+
+	CPU_FREE(set);
+
+	return status == 0;
+}
+
+
+private bool
+thread_read_sysfs(
+	const char* path,
+	uint32_t* value
+	)
+{
+	FILE* file = fopen(path, "r");
+	if(!file)
+	{
+		return false;
+	}
+
+	bool status = fscanf(file, "%u", value) == 1;
+
+	(void) fclose(file);
+
+	return status;
+}
+
+
+private uint32_t
+thread_read_cpu_l3(
+	uint32_t cpu,
+	uint32_t package
+	)
+{
+	for(uint32_t index = 0; index < THREAD_CACHE_MAX_INDEX; ++index)
+	{
+		char path[96];
+		uint32_t level;
+
+		(void) snprintf(path, sizeof(path),
+			"/sys/devices/system/cpu/cpu%u/cache/index%u/level", cpu, index);
+
+		if(!thread_read_sysfs(path, &level))
+		{
+			break;
+		}
+
+		if(level != 3)
+		{
+			continue;
+		}
+
+		uint32_t first;
+
+		(void) snprintf(path, sizeof(path),
+			"/sys/devices/system/cpu/cpu%u/cache/index%u/shared_cpu_list", cpu, index);
+
+		if(thread_read_sysfs(path, &first))
+		{
+			return first;
+		}
+	}
+
+	return UINT32_MAX - package;
+}
+
+
+void
+thread_topology_init(
+	thread_topology_t* topology
+	)
+{
+	assert_not_null(topology);
+
+	long max = sysconf(_SC_NPROCESSORS_CONF);
+	uint32_t max_count = MACRO_MAX(max, 1L);
+
+	topology->cpus = alloc_malloc(sizeof(*topology->cpus) * max_count);
+	assert_not_null(topology->cpus);
+
+	uint32_t* keys = alloc_malloc(sizeof(*keys) * max_count * 2);
+	assert_not_null(keys);
+
+	topology->cpu_count = 0;
+	topology->core_count = 0;
+	topology->l3_count = 0;
+
+	for(uint32_t id = 0; id < max_count; ++id)
+	{
+		char path[96];
+		uint32_t package;
+		uint32_t core;
+
+		(void) snprintf(path, sizeof(path),
+			"/sys/devices/system/cpu/cpu%u/topology/physical_package_id", id);
+
+		if(!thread_read_sysfs(path, &package))
+		{
+			continue;
+		}
+
+		(void) snprintf(path, sizeof(path),
+			"/sys/devices/system/cpu/cpu%u/topology/core_id", id);
+
+		if(!thread_read_sysfs(path, &core))
+		{
+			continue;
+		}
+
+		uint32_t l3 = thread_read_cpu_l3(id, package);
+
+		thread_cpu_t* cpu = &topology->cpus[topology->cpu_count];
+		uint32_t* key = &keys[topology->cpu_count * 2];
+
+		cpu->id = id;
+		cpu->package = package;
+		cpu->core = topology->core_count;
+		cpu->smt = 0;
+		cpu->l3 = topology->l3_count;
+
+		bool new_core = true;
+		bool new_l3 = true;
+
+		for(uint32_t i = 0; i < topology->cpu_count; ++i)
+		{
+			thread_cpu_t* other = &topology->cpus[i];
+			uint32_t* other_key = &keys[i * 2];
+
+			if(new_core && other->package == package && other_key[0] == core)
+			{
+				cpu->core = other->core;
+				new_core = false;
+			}
+
+			if(new_l3 && other_key[1] == l3)
+			{
+				cpu->l3 = other->l3;
+				new_l3 = false;
+			}
+
+			if(!new_core && other->core == cpu->core)
+			{
+				++cpu->smt;
+			}
+		}
+
+		topology->core_count += new_core;
+		topology->l3_count += new_l3;
+
+		key[0] = core;
+		key[1] = l3;
+
+		++topology->cpu_count;
+	}
+
+	alloc_free(keys, sizeof(*keys) * max_count * 2);
+
+	if(!topology->cpu_count)
+	{
+		uint32_t count = MACRO_MIN(thread_get_cpu_count(), max_count);
+
+		for(uint32_t id = 0; id < count; ++id)
+		{
+			topology->cpus[id] =
+			(thread_cpu_t)
+			{
+				.id = id,
+				.package = 0,
+				.core = id,
+				.smt = 0,
+				.l3 = 0
+			};
+		}
+
+		topology->cpu_count = count;
+		topology->core_count = count;
+		topology->l3_count = 1;
+	}
+
+	topology->cpus = alloc_realloc(topology->cpus, sizeof(*topology->cpus) * max_count,
+		sizeof(*topology->cpus) * topology->cpu_count, 0);
+	assert_not_null(topology->cpus);
+}
+
+
+void
+thread_topology_free(
+	thread_topology_t* topology
+	)
+{
+	assert_not_null(topology);
 
-		threads->size = new_size;
+	alloc_free(topology->cpus, sizeof(*topology->cpus) * topology->cpu_count);
+}
+
+
+uint32_t
+thread_topology_get_core_cpus(
+	const thread_topology_t* topology,
+	uint32_t core,
+	uint32_t* cpus
+	)
+{
+	assert_not_null(topology);
+	assert_lt(core, topology->core_count);
+	assert_not_null(cpus);
+
+	uint32_t count = 0;
+
+	for(uint32_t i = 0; i < topology->cpu_count; ++i)
+	{
+		if(topology->cpus[i].core == core)
+		{
+			cpus[count++] = topology->cpus[i].id;
+		}
 	}
+
+	return count;
+}
+
+
+bool
+thread_set_core_affinity(
+	thread_t thread,
+	const thread_topology_t* topology,
+	uint32_t core
+	)
+{
+	assert_not_null(topology);
+
+	uint32_t* cpus = alloc_malloc(sizeof(*cpus) * topology->cpu_count);
+	assert_not_null(cpus);
+
+	uint32_t count = thread_topology_get_core_cpus(topology, core, cpus);
+	bool status = thread_set_affinity(thread, cpus, count);
+
+	alloc_free(cpus, sizeof(*cpus) * topology->cpu_count);
+
+	return status;
 }
 
 
@@ -271,9 +676,7 @@ threads_init(
 {
 	assert_not_null(threads);
 
-	threads->threads = NULL;
-	threads->used = 0;
-	threads->size = 0;
+	alloc_vec_init(&threads->threads, sizeof(thread_t), THREADS_MAX_COUNT);
 }
 
 
@@ -284,7 +687,7 @@ threads_free(
 {
 	assert_not_null(threads);
 
-	alloc_free(threads->threads, sizeof(*threads->threads) * threads->size);
+	alloc_vec_free(&threads->threads);
 }
 
 
@@ -297,17 +700,15 @@ threads_add(
 {
 	assert_not_null(threads);
 
-	threads_resize(threads, count);
+	thread_t* thread = alloc_vec_push(&threads->threads, count);
+	assert_not_null(thread);
 
-	thread_t* thread = threads->threads + threads->used;
 	thread_t* thread_end = thread + count;
 
 	for(; thread != thread_end; ++thread)
 	{
 		thread_init(thread, data);
 	}
-
-	threads->used += count;
 }
 
 
@@ -318,9 +719,10 @@ threads_cancel_sync(
 	)
 {
 	assert_not_null(threads);
-	assert_le(count, threads->used);
+	assert_le(count, threads->threads.count);
 
-	thread_t* thread_start = threads->threads + threads->used - count;
+	thread_t* thread_start = (thread_t*) threads->threads.data
+		+ threads->threads.count - count;
 
 	thread_t* thread = thread_start;
 	thread_t* thread_end = thread + count;
@@ -348,7 +750,7 @@ threads_cancel_sync(
 		}
 	}
 
-	threads_resize(threads, -count);
+	alloc_vec_pop(&threads->threads, count);
 
 	if(found_self)
 	{
@@ -365,9 +767,10 @@ threads_cancel_async(
 	)
 {
 	assert_not_null(threads);
-	assert_le(count, threads->used);
+	assert_le(count, threads->threads.count);
 
-	thread_t* thread_start = threads->threads + threads->used - count;
+	thread_t* thread_start = (thread_t*) threads->threads.data
+		+ threads->threads.count - count;
 
 	thread_t* thread = thread_start;
 	thread_t* thread_end = thread + count;
@@ -388,7 +791,7 @@ threads_cancel_async(
 		}
 	}
 
-	threads_resize(threads, -count);
+	alloc_vec_pop(&threads->threads, count);
 
 	if(found_self)
 	{
@@ -403,7 +806,7 @@ threads_cancel_all_sync(
 	threads_t* threads
 	)
 {
-	threads_cancel_sync(threads, threads->used);
+	threads_cancel_sync(threads, threads->threads.count);
 }
 
 
@@ -412,7 +815,7 @@ threads_cancel_all_async(
 	threads_t* threads
 	)
 {
-	threads_cancel_async(threads, threads->used);
+	threads_cancel_async(threads, threads->threads.count);
 }
 
 
@@ -431,6 +834,49 @@ thread_pool_fn(
 }
 
 
+struct thread_pool_cell
+{
+	alloc_t _Atomic seq;
+	thread_data_t data;
+};
+
+
+private _Thread_local uint32_t thread_pool_take_count;
+
+
+private void
+thread_pool_queue_init(
+	thread_pool_queue_t* queue,
+	alloc_t max_count
+	)
+{
+	queue->ring = alloc_malloc(sizeof(*queue->ring) * THREAD_POOL_RING_SIZE);
+	assert_not_null(queue->ring);
+
+	for(alloc_t i = 0; i < THREAD_POOL_RING_SIZE; ++i)
+	{
+		atomic_init(&queue->ring[i].seq, i);
+	}
+
+	atomic_init(&queue->head, 0);
+	atomic_init(&queue->tail, 0);
+
+	alloc_vec_init(&queue->queue, sizeof(thread_data_t), max_count);
+	queue->queue_head = 0;
+	atomic_init(&queue->queue_count, 0);
+}
+
+
+private void
+thread_pool_queue_free(
+	thread_pool_queue_t* queue
+	)
+{
+	alloc_vec_free(&queue->queue);
+	alloc_free(queue->ring, sizeof(*queue->ring) * THREAD_POOL_RING_SIZE);
+}
+
+
 void
 thread_pool_init(
 	thread_pool_t* pool
@@ -441,9 +887,13 @@ thread_pool_init(
 	sync_sem_init(&pool->sem, 0);
 	sync_mtx_init(&pool->mtx);
 
-	pool->queue = NULL;
-	pool->used = 0;
-	pool->size = 0;
+	atomic_init(&pool->idle_count, 0);
+
+	for(uint32_t i = 0; i < THREAD_PRIORITY__COUNT; ++i)
+	{
+		thread_pool_queue_init(&pool->queues[i], i == THREAD_PRIORITY_NORMAL
+			? THREAD_POOL_MAX_COUNT : THREAD_POOL_PRIORITY_MAX_COUNT);
+	}
 }
 
 
@@ -454,7 +904,10 @@ thread_pool_free(
 {
 	assert_not_null(pool);
 
-	alloc_free(pool->queue, sizeof(*pool->queue) * pool->size);
+	for(uint32_t i = 0; i < THREAD_PRIORITY__COUNT; ++i)
+	{
+		thread_pool_queue_free(&pool->queues[i]);
+	}
 
 	sync_mtx_free(&pool->mtx);
 	sync_sem_free(&pool->sem);
@@ -483,55 +936,265 @@ thread_pool_unlock(
 }
 
 
-private void
-thread_pool_resize(
-	thread_pool_t* pool,
-	uint32_t count
+private bool
+thread_pool_ring_push(
+	thread_pool_queue_t* queue,
+	thread_data_t data
 	)
 {
-	uint32_t new_used = pool->used + count;
+	alloc_t pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
 
-	if((new_used < (pool->size >> 2)) || (new_used > pool->size))
+	while(1)
 	{
-		uint32_t new_size = (new_used << 1) | 1;
-
-		pool->queue = alloc_remalloc(
-			pool->queue,
-			sizeof(*pool->queue) * pool->size,
-			sizeof(*pool->queue) * new_size
-			);
-		assert_not_null(pool->queue);
+		thread_pool_cell_t* cell = &queue->ring[pos & (THREAD_POOL_RING_SIZE - 1)];
+		alloc_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+		intptr_t diff = (intptr_t) seq - (intptr_t) pos;
 
-		pool->size = new_size;
+		if(diff == 0)
+		{
+			if(atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos + 1,
+				memory_order_relaxed, memory_order_relaxed))
+			{
+				cell->data = data;
+				atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+
+				return true;
+			}
+		}
+		else if(diff < 0)
+		{
+			return false;
+		}
+		else
+		{
+			pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+		}
 	}
 }
 
 
-private void
-thread_pool_add_common(
-	thread_pool_t* pool,
-	thread_data_t data,
-	bool lock
+private bool
+thread_pool_ring_pop(
+	thread_pool_queue_t* queue,
+	thread_data_t* data
 	)
 {
-	assert_not_null(pool);
-	assert_not_null(data.fn);
+	alloc_t pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
 
-	if(lock)
+	while(1)
 	{
-		thread_pool_lock(pool);
-	}
-
-	thread_pool_resize(pool, 1);
-
-	pool->queue[pool->used++] = data;
+		thread_pool_cell_t* cell = &queue->ring[pos & (THREAD_POOL_RING_SIZE - 1)];
+		alloc_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+		intptr_t diff = (intptr_t) seq - (intptr_t)(pos + 1);
+
+		if(diff == 0)
+		{
+			if(atomic_compare_exchange_weak_explicit(&queue->head, &pos, pos + 1,
+				memory_order_relaxed, memory_order_relaxed))
+			{
+				*data = cell->data;
+				atomic_store_explicit(&cell->seq,
+					pos + THREAD_POOL_RING_SIZE, memory_order_release);
+
+				return true;
+			}
+		}
+		else if(diff < 0)
+		{
+			return false;
+		}
+		else
+		{
+			pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+		}
+	}
+}
+
+
+private bool
+thread_pool_overflow_push(
+	thread_pool_t* pool,
+	thread_pool_queue_t* queue,
+	thread_data_t data,
+	bool lock
+	)
+{
+	if(lock)
+	{
+		thread_pool_lock(pool);
+	}
+
+	/* The ring only takes new tasks once the overflow has drained */
+	bool status = !atomic_load_explicit(&queue->queue_count, memory_order_relaxed) &&
+		thread_pool_ring_push(queue, data);
+
+	if(!status)
+	{
+		thread_data_t* task = alloc_vec_push(&queue->queue, 1);
+
+		status = task != NULL;
+		if(status)
+		{
+			*task = data;
+
+			atomic_fetch_add_explicit(&queue->queue_count, 1, memory_order_release);
+		}
+	}
+
+	if(lock)
+	{
+		thread_pool_unlock(pool);
+	}
+
+	return status;
+}
+
+
+private bool
+thread_pool_queue_push(
+	thread_pool_t* pool,
+	thread_pool_queue_t* queue,
+	thread_data_t data,
+	bool lock
+	)
+{
+	if(!atomic_load_explicit(&queue->queue_count, memory_order_acquire) &&
+		thread_pool_ring_push(queue, data))
+	{
+		return true;
+	}
+
+	return thread_pool_overflow_push(pool, queue, data, lock);
+}
+
+
+private bool
+thread_pool_overflow_pop(
+	thread_pool_t* pool,
+	thread_pool_queue_t* queue,
+	thread_data_t* data,
+	bool lock
+	)
+{
+	if(!atomic_load_explicit(&queue->queue_count, memory_order_acquire))
+	{
+		return false;
+	}
+
+	if(lock)
+	{
+		thread_pool_lock(pool);
+	}
+
+	bool status = queue->queue_head < queue->queue.count;
+	if(status)
+	{
+		thread_data_t* tasks = queue->queue.data;
+		alloc_t head = queue->queue_head;
+
+		*data = tasks[head++];
+
+		/* Refill the ring oldest first so later pops skip the lock */
+		while(head < queue->queue.count && thread_pool_ring_push(queue, tasks[head]))
+		{
+			++head;
+		}
+
+		atomic_fetch_sub_explicit(&queue->queue_count,
+			head - queue->queue_head, memory_order_relaxed);
+
+		alloc_t count = queue->queue.count - head;
+
+		if(!count)
+		{
+			alloc_vec_pop(&queue->queue, queue->queue.count);
+			head = 0;
+		}
+		else if(head >= count)
+		{
+			memmove(tasks, tasks + head, sizeof(*tasks) * count);
+			alloc_vec_pop(&queue->queue, head);
+			head = 0;
+		}
+
+		queue->queue_head = head;
+	}
 
 	if(lock)
 	{
 		thread_pool_unlock(pool);
 	}
 
-	sync_sem_post(&pool->sem);
+	return status;
+}
+
+
+private bool
+thread_pool_queue_has_work(
+	thread_pool_queue_t* queue
+	)
+{
+	return atomic_load_explicit(&queue->tail, memory_order_seq_cst) !=
+		atomic_load_explicit(&queue->head, memory_order_seq_cst) ||
+		atomic_load_explicit(&queue->queue_count, memory_order_seq_cst);
+}
+
+
+private bool
+thread_pool_has_work(
+	thread_pool_t* pool
+	)
+{
+	for(uint32_t i = 0; i < THREAD_PRIORITY__COUNT; ++i)
+	{
+		if(thread_pool_queue_has_work(&pool->queues[i]))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+private void
+thread_pool_wake(
+	thread_pool_t* pool,
+	alloc_t count
+	)
+{
+	/* Pairs with the fence in thread_pool_work_common */
+	atomic_thread_fence(memory_order_seq_cst);
+
+	uint32_t idle = atomic_load_explicit(&pool->idle_count, memory_order_relaxed);
+
+	sync_sem_post_n(&pool->sem, MACRO_MIN(count, idle));
+}
+
+
+private void
+thread_pool_add_common(
+	thread_pool_t* pool,
+	thread_data_t data,
+	thread_priority_t priority,
+	bool lock
+	)
+{
+	assert_not_null(pool);
+	assert_not_null(data.fn);
+	assert_lt(priority, THREAD_PRIORITY__COUNT);
+
+	thread_pool_queue_t* queue = &pool->queues[priority];
+
+	if(!thread_pool_queue_push(pool, queue, data, lock))
+	{
+		/* Both queues are full, run the task here rather than drop it */
+		data.fn(data.data);
+
+		return;
+	}
+
+	thread_pool_wake(pool, 1);
 }
 
 
@@ -541,7 +1204,7 @@ thread_pool_add_u(
 	thread_data_t data
 	)
 {
-	thread_pool_add_common(pool, data, false);
+	thread_pool_add_common(pool, data, THREAD_PRIORITY_NORMAL, false);
 }
 
 
@@ -551,47 +1214,195 @@ thread_pool_add(
 	thread_data_t data
 	)
 {
-	thread_pool_add_common(pool, data, true);
+	thread_pool_add_common(pool, data, THREAD_PRIORITY_NORMAL, true);
 }
 
 
-private bool
-thread_pool_try_work_common(
+void
+thread_pool_add_priority_u(
+	thread_pool_t* pool,
+	thread_data_t data,
+	thread_priority_t priority
+	)
+{
+	thread_pool_add_common(pool, data, priority, false);
+}
+
+
+void
+thread_pool_add_priority(
+	thread_pool_t* pool,
+	thread_data_t data,
+	thread_priority_t priority
+	)
+{
+	thread_pool_add_common(pool, data, priority, true);
+}
+
+
+private void
+thread_pool_add_batch_common(
 	thread_pool_t* pool,
+	const thread_data_t* tasks,
+	alloc_t count,
+	thread_priority_t priority,
 	bool lock
 	)
 {
 	assert_not_null(pool);
+	assert_ptr(tasks, count);
+	assert_lt(priority, THREAD_PRIORITY__COUNT);
 
-	if(lock)
+	thread_pool_queue_t* queue = &pool->queues[priority];
+	alloc_t pushed = 0;
+
+	for(; pushed < count; ++pushed)
 	{
-		thread_pool_lock(pool);
+		assert_not_null(tasks[pushed].fn);
+
+		if(atomic_load_explicit(&queue->queue_count, memory_order_acquire) ||
+			!thread_pool_ring_push(queue, tasks[pushed]))
+		{
+			break;
+		}
 	}
 
-	if(!pool->used)
+	if(pushed < count)
 	{
+		if(lock)
+		{
+			thread_pool_lock(pool);
+		}
+
+		for(; pushed < count; ++pushed)
+		{
+			assert_not_null(tasks[pushed].fn);
+
+			if(!thread_pool_overflow_push(pool, queue, tasks[pushed], false))
+			{
+				break;
+			}
+		}
+
 		if(lock)
 		{
 			thread_pool_unlock(pool);
 		}
+	}
 
-		return false;
+	thread_pool_wake(pool, pushed);
+
+	/* Both queues are full, run the rest here rather than drop them */
+	for(; pushed < count; ++pushed)
+	{
+		tasks[pushed].fn(tasks[pushed].data);
 	}
+}
+
+
+void
+thread_pool_add_batch_u(
+	thread_pool_t* pool,
+	const thread_data_t* tasks,
+	alloc_t count
+	)
+{
+	thread_pool_add_batch_common(pool, tasks, count, THREAD_PRIORITY_NORMAL, false);
+}
+
+
+void
+thread_pool_add_batch(
+	thread_pool_t* pool,
+	const thread_data_t* tasks,
+	alloc_t count
+	)
+{
+	thread_pool_add_batch_common(pool, tasks, count, THREAD_PRIORITY_NORMAL, true);
+}
+
+
+void
+thread_pool_add_batch_priority_u(
+	thread_pool_t* pool,
+	const thread_data_t* tasks,
+	alloc_t count,
+	thread_priority_t priority
+	)
+{
+	thread_pool_add_batch_common(pool, tasks, count, priority, false);
+}
+
+
+void
+thread_pool_add_batch_priority(
+	thread_pool_t* pool,
+	const thread_data_t* tasks,
+	alloc_t count,
+	thread_priority_t priority
+	)
+{
+	thread_pool_add_batch_common(pool, tasks, count, priority, true);
+}
+
+
+private bool
+thread_pool_take_from(
+	thread_pool_t* pool,
+	thread_priority_t priority,
+	thread_data_t* data,
+	bool lock
+	)
+{
+	thread_pool_queue_t* queue = &pool->queues[priority];
+
+	return thread_pool_ring_pop(queue, data) ||
+		thread_pool_overflow_pop(pool, queue, data, lock);
+}
+
 
-	thread_data_t data = *pool->queue;
+private bool
+thread_pool_take(
+	thread_pool_t* pool,
+	thread_data_t* data,
+	bool lock
+	)
+{
+	uint32_t tick = thread_pool_take_count++;
+	uint32_t first = 0;
 
-	if(pool->used - 1)
+	if(tick % THREAD_POOL_STARVATION_PERIOD == 0)
 	{
-		(void) memmove(pool->queue, pool->queue + 1,
-			sizeof(*pool->queue) * (pool->used - 1));
+		first = (tick / THREAD_POOL_STARVATION_PERIOD) % THREAD_PRIORITY__COUNT;
 	}
 
-	thread_pool_resize(pool, -1);
-	--pool->used;
+	for(uint32_t i = 0; i < THREAD_PRIORITY__COUNT; ++i)
+	{
+		thread_priority_t priority = (first + i) % THREAD_PRIORITY__COUNT;
 
-	if(lock)
+		if(thread_pool_take_from(pool, priority, data, lock))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+private bool
+thread_pool_try_work_common(
+	thread_pool_t* pool,
+	bool lock
+	)
+{
+	assert_not_null(pool);
+
+	thread_data_t data;
+
+	if(!thread_pool_take(pool, &data, lock))
 	{
-		thread_pool_unlock(pool);
+		return false;
 	}
 
 	data.fn(data.data);
@@ -618,35 +1429,1137 @@ thread_pool_try_work(
 }
 
 
-void
-thread_pool_work_u(
-	thread_pool_t* pool
+private void
+thread_pool_work_common(
+	thread_pool_t* pool,
+	bool lock
 	)
 {
 	assert_not_null(pool);
 
-	sync_sem_wait(&pool->sem);
+	thread_data_t data;
+
+	while(1)
+	{
+		thread_async_off();
+			thread_cancel_off();
+				bool status = thread_pool_take(pool, &data, lock);
+			thread_cancel_on();
+		thread_async_on();
+
+		if(status)
+		{
+			break;
+		}
+
+		if(thread_spin((void*) thread_pool_has_work, pool))
+		{
+			continue;
+		}
+
+		atomic_fetch_add_explicit(&pool->idle_count, 1, memory_order_relaxed);
+		atomic_thread_fence(memory_order_seq_cst);
+
+		if(!thread_pool_has_work(pool))
+		{
+			sync_sem_wait(&pool->sem);
+		}
+
+		atomic_fetch_sub_explicit(&pool->idle_count, 1, memory_order_relaxed);
+	}
 
 	thread_async_off();
 		thread_cancel_off();
-			(void) thread_pool_try_work_u(pool);
+			data.fn(data.data);
 		thread_cancel_on();
 	thread_async_on();
 }
 
 
 void
-thread_pool_work(
+thread_pool_work_u(
 	thread_pool_t* pool
 	)
 {
-	assert_not_null(pool);
+	thread_pool_work_common(pool, false);
+}
 
-	sync_sem_wait(&pool->sem);
 
-	thread_async_off();
-		thread_cancel_off();
-			(void) thread_pool_try_work(pool);
-		thread_cancel_on();
-	thread_async_on();
+void
+thread_pool_work(
+	thread_pool_t* pool
+	)
+{
+	thread_pool_work_common(pool, true);
+}
+
+
+bool
+thread_pool_should_yield(
+	thread_pool_t* pool
+	)
+{
+	assert_not_null(pool);
+
+	thread_pool_queue_t* queue = &pool->queues[THREAD_PRIORITY_CRITICAL];
+
+	return atomic_load_explicit(&queue->tail, memory_order_relaxed) !=
+		atomic_load_explicit(&queue->head, memory_order_relaxed) ||
+		atomic_load_explicit(&queue->queue_count, memory_order_relaxed);
+}
+
+
+private bool
+thread_pool_yield_common(
+	thread_pool_t* pool,
+	bool lock
+	)
+{
+	assert_not_null(pool);
+
+	thread_data_t data;
+	bool status = false;
+
+	while(thread_pool_take_from(pool, THREAD_PRIORITY_CRITICAL, &data, lock))
+	{
+		data.fn(data.data);
+		status = true;
+	}
+
+	return status;
+}
+
+
+bool
+thread_pool_yield_u(
+	thread_pool_t* pool
+	)
+{
+	return thread_pool_yield_common(pool, false);
+}
+
+
+bool
+thread_pool_yield(
+	thread_pool_t* pool
+	)
+{
+	return thread_pool_yield_common(pool, true);
+}
+
+
+typedef struct thread_sched_slot
+{
+	thread_fn_t _Atomic fn;
+	void* _Atomic data;
+}
+thread_sched_slot_t;
+
+
+struct thread_sched_worker
+{
+	int64_t _Atomic top;
+	int64_t _Atomic bottom;
+	thread_sched_slot_t* tasks;
+
+	thread_sched_t* sched;
+	uint32_t seed;
+};
+
+
+private _Thread_local thread_sched_worker_t* thread_sched_worker;
+
+
+private void
+thread_sched_slot_store(
+	thread_sched_slot_t* slot,
+	thread_data_t data
+	)
+{
+	atomic_store_explicit(&slot->fn, data.fn, memory_order_relaxed);
+	atomic_store_explicit(&slot->data, data.data, memory_order_relaxed);
+}
+
+
+private thread_data_t
+thread_sched_slot_load(
+	thread_sched_slot_t* slot
+	)
+{
+	return
+	(thread_data_t)
+	{
+		.fn = atomic_load_explicit(&slot->fn, memory_order_relaxed),
+		.data = atomic_load_explicit(&slot->data, memory_order_relaxed)
+	};
+}
+
+
+private bool
+thread_sched_push(
+	thread_sched_worker_t* worker,
+	thread_data_t data
+	)
+{
+	int64_t bottom = atomic_load_explicit(&worker->bottom, memory_order_relaxed);
+	int64_t top = atomic_load_explicit(&worker->top, memory_order_acquire);
+
+	if(bottom - top >= THREAD_SCHED_DEQUE_SIZE)
+	{
+		return false;
+	}
+
+	thread_sched_slot_store(&worker->tasks[bottom & (THREAD_SCHED_DEQUE_SIZE - 1)], data);
+
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_relaxed);
+
+	return true;
+}
+
+
+private bool
+thread_sched_pop(
+	thread_sched_worker_t* worker,
+	thread_data_t* data
+	)
+{
+	int64_t bottom = atomic_load_explicit(&worker->bottom, memory_order_relaxed) - 1;
+	atomic_store_explicit(&worker->bottom, bottom, memory_order_relaxed);
+
+	atomic_thread_fence(memory_order_seq_cst);
+
+	int64_t top = atomic_load_explicit(&worker->top, memory_order_relaxed);
+
+	if(top > bottom)
+	{
+		atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_relaxed);
+		return false;
+	}
+
+	*data = thread_sched_slot_load(&worker->tasks[bottom & (THREAD_SCHED_DEQUE_SIZE - 1)]);
+
+	if(top != bottom)
+	{
+		return true;
+	}
+
+	bool status = atomic_compare_exchange_strong_explicit(&worker->top, &top,
+		top + 1, memory_order_seq_cst, memory_order_relaxed);
+
+	atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_relaxed);
+
+	return status;
+}
+
+
+private bool
+thread_sched_steal(
+	thread_sched_worker_t* worker,
+	thread_data_t* data
+	)
+{
+	int64_t top = atomic_load_explicit(&worker->top, memory_order_acquire);
+
+	atomic_thread_fence(memory_order_seq_cst);
+
+	int64_t bottom = atomic_load_explicit(&worker->bottom, memory_order_acquire);
+
+	if(top >= bottom)
+	{
+		return false;
+	}
+
+	*data = thread_sched_slot_load(&worker->tasks[top & (THREAD_SCHED_DEQUE_SIZE - 1)]);
+
+	return atomic_compare_exchange_strong_explicit(&worker->top, &top,
+		top + 1, memory_order_seq_cst, memory_order_relaxed);
+}
+
+
+private thread_sched_worker_t*
+thread_sched_get_worker(
+	thread_sched_t* sched
+	)
+{
+	thread_sched_worker_t* worker = thread_sched_worker;
+
+	return worker && worker->sched == sched ? worker : NULL;
+}
+
+
+private void
+thread_sched_wake(
+	thread_sched_t* sched,
+	uint32_t count
+	)
+{
+	/* Pairs with the fence in thread_sched_fn */
+	atomic_thread_fence(memory_order_seq_cst);
+
+	uint32_t idle = atomic_load_explicit(&sched->idle_count, memory_order_relaxed);
+
+	sync_sem_post_n(&sched->sem, MACRO_MIN(count, idle));
+}
+
+
+private void
+thread_sched_publish(
+	thread_sched_t* sched,
+	thread_sched_worker_t* worker,
+	thread_data_t data
+	)
+{
+	assert_not_null(data.fn);
+
+	if(!worker || !thread_sched_push(worker, data))
+	{
+		thread_pool_add(&sched->pool, data);
+	}
+}
+
+
+void
+thread_sched_add(
+	thread_sched_t* sched,
+	thread_data_t data
+	)
+{
+	assert_not_null(sched);
+
+	thread_sched_publish(sched, thread_sched_get_worker(sched), data);
+	thread_sched_wake(sched, 1);
+}
+
+
+void
+thread_sched_add_batch(
+	thread_sched_t* sched,
+	const thread_data_t* tasks,
+	uint32_t count
+	)
+{
+	assert_not_null(sched);
+	assert_ptr(tasks, count);
+
+	thread_sched_worker_t* worker = thread_sched_get_worker(sched);
+
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		thread_sched_publish(sched, worker, tasks[i]);
+	}
+
+	thread_sched_wake(sched, count);
+}
+
+
+private bool
+thread_sched_try_steal(
+	thread_sched_t* sched,
+	thread_sched_worker_t* self,
+	thread_data_t* data
+	)
+{
+	uint32_t start;
+
+	if(self)
+	{
+		self->seed ^= self->seed << 13;
+		self->seed ^= self->seed >> 17;
+		self->seed ^= self->seed << 5;
+
+		start = self->seed % sched->worker_count;
+	}
+	else
+	{
+		start = 0;
+	}
+
+	for(uint32_t i = 0; i < sched->worker_count; ++i)
+	{
+		thread_sched_worker_t* victim =
+			&sched->workers[(start + i) % sched->worker_count];
+
+		if(victim != self && thread_sched_steal(victim, data))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+bool
+thread_sched_try_work(
+	thread_sched_t* sched
+	)
+{
+	assert_not_null(sched);
+
+	thread_sched_worker_t* worker = thread_sched_get_worker(sched);
+	thread_data_t data;
+
+	if(worker && thread_sched_pop(worker, &data))
+	{
+		data.fn(data.data);
+		return true;
+	}
+
+	if(thread_pool_try_work(&sched->pool))
+	{
+		return true;
+	}
+
+	if(thread_sched_try_steal(sched, worker, &data))
+	{
+		data.fn(data.data);
+		return true;
+	}
+
+	return false;
+}
+
+
+private bool
+thread_sched_has_work(
+	thread_sched_t* sched
+	)
+{
+	if(thread_pool_has_work(&sched->pool))
+	{
+		return true;
+	}
+
+	for(uint32_t i = 0; i < sched->worker_count; ++i)
+	{
+		thread_sched_worker_t* worker = &sched->workers[i];
+
+		if(atomic_load_explicit(&worker->top, memory_order_seq_cst) <
+			atomic_load_explicit(&worker->bottom, memory_order_seq_cst))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+private void
+thread_sched_fn(
+	void* data
+	)
+{
+	thread_sched_worker_t* worker = data;
+	thread_sched_t* sched = worker->sched;
+
+	thread_sched_worker = worker;
+
+	while(1)
+	{
+		thread_async_off();
+			thread_cancel_off();
+				while(thread_sched_try_work(sched));
+			thread_cancel_on();
+		thread_async_on();
+
+		if(thread_spin((void*) thread_sched_has_work, sched))
+		{
+			continue;
+		}
+
+		atomic_fetch_add_explicit(&sched->idle_count, 1, memory_order_relaxed);
+		atomic_thread_fence(memory_order_seq_cst);
+
+		if(!thread_sched_has_work(sched))
+		{
+			sync_sem_wait(&sched->sem);
+		}
+
+		atomic_fetch_sub_explicit(&sched->idle_count, 1, memory_order_relaxed);
+	}
+}
+
+
+void
+thread_sched_init(
+	thread_sched_t* sched,
+	uint32_t worker_count
+	)
+{
+	assert_not_null(sched);
+	assert_gt(worker_count, 0);
+
+	thread_pool_init(&sched->pool);
+
+	sync_sem_init(&sched->sem, 0);
+	atomic_init(&sched->idle_count, 0);
+
+	sched->workers = alloc_malloc(sizeof(*sched->workers) * worker_count);
+	assert_not_null(sched->workers);
+
+	sched->worker_count = worker_count;
+
+	for(uint32_t i = 0; i < worker_count; ++i)
+	{
+		thread_sched_worker_t* worker = &sched->workers[i];
+
+		atomic_init(&worker->top, 0);
+		atomic_init(&worker->bottom, 0);
+
+		worker->tasks = alloc_malloc(sizeof(*worker->tasks) * THREAD_SCHED_DEQUE_SIZE);
+		assert_not_null(worker->tasks);
+
+		worker->sched = sched;
+		worker->seed = i * 2654435761U + 1;
+	}
+
+	threads_init(&sched->threads);
+
+	for(uint32_t i = 0; i < worker_count; ++i)
+	{
+		threads_add(&sched->threads,
+			(thread_data_t)
+			{
+				.fn = thread_sched_fn,
+				.data = &sched->workers[i]
+			},
+			1
+			);
+	}
+
+	thread_t* threads = sched->threads.threads.data;
+
+	for(uint32_t i = 0; i < worker_count; ++i)
+	{
+		char name[32];
+		(void) snprintf(name, sizeof(name), "sched-%u", i);
+
+		thread_set_name(threads[i], name);
+	}
+}
+
+
+void
+thread_sched_pin(
+	thread_sched_t* sched,
+	const thread_topology_t* topology,
+	uint32_t first_core
+	)
+{
+	assert_not_null(sched);
+	assert_not_null(topology);
+
+	thread_t* threads = sched->threads.threads.data;
+
+	for(uint32_t i = 0; i < sched->worker_count; ++i)
+	{
+		uint32_t core = (first_core + i) % topology->core_count;
+
+		(void) thread_set_core_affinity(threads[i], topology, core);
+	}
+}
+
+
+void
+thread_sched_free(
+	thread_sched_t* sched
+	)
+{
+	assert_not_null(sched);
+
+	threads_cancel_all_sync(&sched->threads);
+	threads_free(&sched->threads);
+
+	for(uint32_t i = 0; i < sched->worker_count; ++i)
+	{
+		alloc_free(sched->workers[i].tasks,
+			sizeof(*sched->workers[i].tasks) * THREAD_SCHED_DEQUE_SIZE);
+	}
+
+	alloc_free(sched->workers, sizeof(*sched->workers) * sched->worker_count);
+
+	sync_sem_free(&sched->sem);
+
+	thread_pool_free(&sched->pool);
+}
+
+
+void
+thread_counter_init(
+	thread_counter_t* counter,
+	uint32_t value
+	)
+{
+	assert_not_null(counter);
+	assert_false(value & THREAD_COUNTER_WAITING);
+
+	atomic_init(&counter->value, value);
+	atomic_init(&counter->waiter_count, 0);
+	sync_sem_init(&counter->sem, 0);
+}
+
+
+void
+thread_counter_free(
+	thread_counter_t* counter
+	)
+{
+	assert_not_null(counter);
+	assert_true(thread_counter_is_done(counter));
+
+	sync_sem_free(&counter->sem);
+}
+
+
+void
+thread_counter_add(
+	thread_counter_t* counter,
+	uint32_t value
+	)
+{
+	assert_not_null(counter);
+
+	uint32_t old = atomic_fetch_add_explicit(&counter->value, value, memory_order_relaxed);
+	assert_false((old & ~THREAD_COUNTER_WAITING) + value > ~THREAD_COUNTER_WAITING);
+}
+
+
+void
+thread_counter_sub(
+	thread_counter_t* counter,
+	uint32_t value
+	)
+{
+	assert_not_null(counter);
+
+	uint32_t old = atomic_fetch_sub_explicit(&counter->value, value, memory_order_acq_rel);
+	assert_ge(old & ~THREAD_COUNTER_WAITING, value);
+
+	if(old - value != THREAD_COUNTER_WAITING)
+	{
+		return;
+	}
+
+	/* Waiters only see the counter as done after the wake below */
+	uint32_t waiter_count = atomic_load_explicit(&counter->waiter_count, memory_order_relaxed);
+	sync_sem_post_n(&counter->sem, waiter_count);
+
+	/* After a concurrent add, the sub that next reaches 0 wakes instead */
+	uint32_t waiting = THREAD_COUNTER_WAITING;
+	atomic_compare_exchange_strong_explicit(&counter->value, &waiting, 0,
+		memory_order_release, memory_order_relaxed);
+}
+
+
+bool
+thread_counter_is_done(
+	thread_counter_t* counter
+	)
+{
+	assert_not_null(counter);
+
+	return !atomic_load_explicit(&counter->value, memory_order_acquire);
+}
+
+
+typedef struct thread_counter_park
+{
+	thread_counter_t* counter;
+	thread_sched_t* sched;
+}
+thread_counter_park_t;
+
+
+private bool
+thread_counter_can_wake(
+	thread_counter_park_t* park
+	)
+{
+	return thread_counter_is_done(park->counter) ||
+		(park->sched && thread_sched_has_work(park->sched));
+}
+
+
+private void
+thread_counter_park(
+	thread_counter_t* counter,
+	thread_sched_t* sched
+	)
+{
+	thread_counter_park_t park =
+	{
+		.counter = counter,
+		.sched = sched
+	};
+
+	if(thread_spin((void*) thread_counter_can_wake, &park))
+	{
+		return;
+	}
+
+	atomic_fetch_add_explicit(&counter->waiter_count, 1, memory_order_relaxed);
+
+	uint32_t value = atomic_load_explicit(&counter->value, memory_order_relaxed);
+
+	while(value & ~THREAD_COUNTER_WAITING)
+	{
+		if(atomic_compare_exchange_weak_explicit(&counter->value, &value,
+			value | THREAD_COUNTER_WAITING, memory_order_acq_rel, memory_order_relaxed))
+		{
+			sync_sem_wait(&counter->sem);
+			break;
+		}
+	}
+
+	atomic_fetch_sub_explicit(&counter->waiter_count, 1, memory_order_relaxed);
+
+	/* The last sub is still waking the other waiters */
+	while(atomic_load_explicit(&counter->value, memory_order_acquire) == THREAD_COUNTER_WAITING)
+	{
+		(void) sched_yield();
+	}
+}
+
+
+void
+thread_counter_wait(
+	thread_counter_t* counter,
+	thread_sched_t* sched
+	)
+{
+	assert_not_null(counter);
+	assert_not_null(sched);
+
+	while(!thread_counter_is_done(counter))
+	{
+		if(!thread_sched_try_work(sched))
+		{
+			thread_counter_park(counter, sched);
+		}
+	}
+}
+
+
+struct thread_job
+{
+	thread_sched_t* sched;
+	thread_data_t data;
+	thread_counter_t* counter;
+
+	uint32_t _Atomic pending;
+	uint32_t continuation_count;
+	thread_job_t* continuations[THREAD_JOB_MAX_CONTINUATIONS];
+};
+
+
+private alloc_pool_t thread_job_pool =
+	ALLOC_POOL_INIT(thread_job_t, ALLOC_POOL_FLAG_THREAD_CACHE);
+
+
+thread_job_t*
+thread_job_init(
+	thread_sched_t* sched,
+	thread_data_t data,
+	thread_counter_t* counter
+	)
+{
+	assert_not_null(sched);
+	assert_not_null(data.fn);
+
+	thread_job_t* job = alloc_pool_alloc(&thread_job_pool, 0);
+	assert_not_null(job);
+
+	job->sched = sched;
+	job->data = data;
+	job->counter = counter;
+
+	atomic_init(&job->pending, 1);
+	job->continuation_count = 0;
+
+	if(counter)
+	{
+		thread_counter_add(counter, 1);
+	}
+
+	return job;
+}
+
+
+void
+thread_job_then(
+	thread_job_t* job,
+	thread_job_t* continuation
+	)
+{
+	assert_not_null(job);
+	assert_not_null(continuation);
+	assert_lt(job->continuation_count, THREAD_JOB_MAX_CONTINUATIONS);
+	assert_gt(atomic_load_explicit(&job->pending, memory_order_relaxed), 0);
+
+	atomic_fetch_add_explicit(&continuation->pending, 1, memory_order_relaxed);
+	job->continuations[job->continuation_count++] = continuation;
+}
+
+
+private void
+thread_job_fn(
+	void* data
+	)
+{
+	thread_job_t* job = data;
+
+	job->data.fn(job->data.data);
+
+	for(uint32_t i = 0; i < job->continuation_count; ++i)
+	{
+		thread_job_submit(job->continuations[i]);
+	}
+
+	if(job->counter)
+	{
+		thread_counter_sub(job->counter, 1);
+	}
+
+	alloc_pool_release(&thread_job_pool, job);
+}
+
+
+void
+thread_job_submit(
+	thread_job_t* job
+	)
+{
+	assert_not_null(job);
+
+	if(atomic_fetch_sub_explicit(&job->pending, 1, memory_order_acq_rel) == 1)
+	{
+		thread_sched_add(job->sched,
+			(thread_data_t)
+			{
+				.fn = thread_job_fn,
+				.data = job
+			}
+			);
+	}
+}
+
+
+typedef struct thread_for
+{
+	thread_for_fn_t fn;
+	thread_reduce_fn_t reduce_fn;
+	void* data;
+
+	uint32_t count;
+	uint32_t grain;
+	uint32_t slot_count;
+	thread_for_flag_t flags;
+	uint32_t _Atomic next;
+
+	uint8_t* partials;
+	alloc_t partial_size;
+
+	thread_counter_t counter;
+}
+thread_for_t;
+
+
+typedef struct thread_for_task
+{
+	thread_for_t* loop;
+	uint32_t index;
+}
+thread_for_task_t;
+
+
+private void
+thread_for_run_range(
+	thread_for_t* loop,
+	uint32_t index,
+	uint32_t begin,
+	uint32_t end
+	)
+{
+	if(loop->reduce_fn)
+	{
+		loop->reduce_fn(loop->data, begin, end,
+			loop->partials + loop->partial_size * index);
+	}
+	else
+	{
+		loop->fn(loop->data, begin, end);
+	}
+}
+
+
+private void
+thread_for_run(
+	thread_for_t* loop,
+	uint32_t index
+	)
+{
+	if(loop->flags & THREAD_FOR_FLAG_STATIC)
+	{
+		alloc_t stride = (alloc_t) loop->grain * loop->slot_count;
+
+		for(alloc_t begin = (alloc_t) loop->grain * index; begin < loop->count; begin += stride)
+		{
+			uint32_t end = MACRO_MIN(begin + loop->grain, loop->count);
+			thread_for_run_range(loop, index, begin, end);
+		}
+
+		return;
+	}
+
+	while(1)
+	{
+		uint32_t begin = atomic_fetch_add_explicit(&loop->next,
+			loop->grain, memory_order_relaxed);
+		if(begin >= loop->count)
+		{
+			break;
+		}
+
+		uint32_t end = MACRO_MIN(begin + loop->grain, loop->count);
+		thread_for_run_range(loop, index, begin, end);
+	}
+}
+
+
+private void
+thread_for_fn(
+	void* data
+	)
+{
+	thread_for_task_t* task = data;
+	thread_for_t* loop = task->loop;
+
+	thread_for_run(loop, task->index);
+
+	thread_counter_sub(&loop->counter, 1);
+}
+
+
+private uint32_t
+thread_for_start(
+	thread_sched_t* sched,
+	thread_for_t* loop,
+	thread_for_task_t** tasks
+	)
+{
+	uint32_t thread_count = sched->worker_count +
+		!!(loop->flags & THREAD_FOR_FLAG_CALLER_RUNS);
+
+	if(!loop->grain)
+	{
+		if(loop->flags & THREAD_FOR_FLAG_STATIC)
+		{
+			loop->grain = (loop->count + thread_count - 1) / thread_count;
+		}
+		else
+		{
+			loop->grain = MACRO_MAX(loop->count /
+				(thread_count * THREAD_FOR_CHUNKS_PER_THREAD), 1U);
+		}
+	}
+
+	uint32_t chunk_count = ((alloc_t) loop->count + loop->grain - 1) / loop->grain;
+	uint32_t slot_count = MACRO_MIN(chunk_count, thread_count);
+	loop->slot_count = slot_count;
+
+	uint32_t task_count = slot_count -
+		!!(loop->flags & THREAD_FOR_FLAG_CALLER_RUNS);
+
+	atomic_init(&loop->next, 0);
+	thread_counter_init(&loop->counter, task_count);
+
+	*tasks = NULL;
+
+	if(task_count)
+	{
+		*tasks = alloc_malloc(sizeof(**tasks) * task_count);
+		assert_not_null(*tasks);
+	}
+
+	thread_sched_worker_t* worker = thread_sched_get_worker(sched);
+
+	for(uint32_t i = 0; i < task_count; ++i)
+	{
+		(*tasks)[i] =
+		(thread_for_task_t)
+		{
+			.loop = loop,
+			.index = i
+		};
+
+		thread_sched_publish(sched, worker,
+			(thread_data_t)
+			{
+				.fn = thread_for_fn,
+				.data = &(*tasks)[i]
+			}
+			);
+	}
+
+	thread_sched_wake(sched, task_count);
+
+	return slot_count;
+}
+
+
+private void
+thread_for_finish(
+	thread_sched_t* sched,
+	thread_for_t* loop,
+	thread_for_task_t* tasks,
+	uint32_t slot_count
+	)
+{
+	uint32_t task_count = slot_count;
+
+	if(loop->flags & THREAD_FOR_FLAG_CALLER_RUNS)
+	{
+		--task_count;
+		thread_for_run(loop, task_count);
+
+		thread_counter_wait(&loop->counter, sched);
+	}
+	else if(thread_sched_get_worker(sched))
+	{
+		thread_counter_wait(&loop->counter, sched);
+	}
+	else
+	{
+		while(!thread_counter_is_done(&loop->counter))
+		{
+			thread_counter_park(&loop->counter, NULL);
+		}
+	}
+
+	thread_counter_free(&loop->counter);
+	alloc_free(tasks, sizeof(*tasks) * task_count);
+}
+
+
+void
+thread_parallel_for(
+	thread_sched_t* sched,
+	uint32_t count,
+	uint32_t grain,
+	thread_for_flag_t flags,
+	thread_for_fn_t fn,
+	void* data
+	)
+{
+	assert_not_null(sched);
+	assert_not_null(fn);
+
+	if(!count)
+	{
+		return;
+	}
+
+	if(grain >= count)
+	{
+		fn(data, 0, count);
+		return;
+	}
+
+	thread_for_t loop =
+	{
+		.fn = fn,
+		.reduce_fn = NULL,
+		.data = data,
+		.count = count,
+		.grain = grain,
+		.flags = flags,
+		.partials = NULL,
+		.partial_size = 0
+	};
+
+	thread_for_task_t* tasks;
+	uint32_t slot_count = thread_for_start(sched, &loop, &tasks);
+
+	thread_for_finish(sched, &loop, tasks, slot_count);
+}
+
+
+void
+thread_parallel_reduce(
+	thread_sched_t* sched,
+	uint32_t count,
+	uint32_t grain,
+	thread_for_flag_t flags,
+	thread_reduce_fn_t fn,
+	thread_combine_fn_t combine_fn,
+	void* data,
+	const void* identity,
+	void* result,
+	alloc_t result_size
+	)
+{
+	assert_not_null(sched);
+	assert_not_null(fn);
+	assert_not_null(combine_fn);
+	assert_not_null(identity);
+	assert_not_null(result);
+	assert_gt(result_size, 0);
+
+	if(!count)
+	{
+		return;
+	}
+
+	alloc_t mask = THREAD_CACHE_LINE_SIZE - 1;
+	alloc_t partial_size = MACRO_ALIGN_UP(result_size, mask);
+
+	uint32_t slot_max = sched->worker_count + 1;
+	alloc_t partials_size = partial_size * slot_max + mask;
+
+	uint8_t* partials_ptr = alloc_malloc(partials_size);
+	assert_not_null(partials_ptr);
+
+	uint8_t* partials = MACRO_ALIGN_UP(partials_ptr, mask);
+
+	thread_for_t loop =
+	{
+		.fn = NULL,
+		.reduce_fn = fn,
+		.data = data,
+		.count = count,
+		.grain = grain,
+		.flags = flags,
+		.partials = partials,
+		.partial_size = partial_size
+	};
+
+	uint32_t slot_count;
+	thread_for_task_t* tasks = NULL;
+
+	if(grain >= count)
+	{
+		(void) memcpy(partials, identity, result_size);
+		fn(data, 0, count, partials);
+
+		slot_count = 1;
+	}
+	else
+	{
+		for(uint32_t i = 0; i < slot_max; ++i)
+		{
+			(void) memcpy(partials + partial_size * i, identity, result_size);
+		}
+
+		slot_count = thread_for_start(sched, &loop, &tasks);
+		thread_for_finish(sched, &loop, tasks, slot_count);
+	}
+
+	for(uint32_t i = 0; i < slot_count; ++i)
+	{
+		combine_fn(data, result, partials + partial_size * i);
+	}
+
+	alloc_free(partials_ptr, partials_size);
 }
@@ -22,6 +22,9 @@
 #include <stdatomic.h>
 
 
+#define TIME_TIMERS_MAX_COUNT MACRO_POWER_OF_2(22)
+
+
 uint64_t
 time_sec_to_ms(
 	uint64_t sec
@@ -186,11 +189,11 @@ struct time_timers
 {
 	time_timeout_t* timeouts;
 	uint32_t timeouts_used;
-	uint32_t timeouts_size;
+	alloc_vec_t timeouts_vec;
 
 	time_interval_t* intervals;
 	uint32_t intervals_used;
-	uint32_t intervals_size;
+	alloc_vec_t intervals_vec;
 
 	thread_t thread;
 	sync_mtx_t mtx;
@@ -355,7 +358,7 @@ time_timers_free_##names (																		\
 	time_timers_t timers																		\
 	)																							\
 {																								\
-	alloc_free(timers-> names , sizeof(* timers-> names ) * timers-> names##_size );			\
+	alloc_vec_free(&timers-> names##_vec );														\
 }																								\
 																								\
 																								\
@@ -365,20 +368,9 @@ time_timers_resize_##names (																	\
 	uint32_t count																				\
 	)																							\
 {																								\
-	uint32_t new_used = timers-> names##_used + count;											\
-																								\
-	if((new_used < (timers-> names##_size >> 2)) || (new_used > timers-> names##_size ))		\
-	{																							\
-		uint32_t new_size = (new_used << 1) | 1;												\
-																								\
-		timers-> names = alloc_remalloc(														\
-			timers-> names ,																	\
-			sizeof(* timers-> names ) * timers-> names##_size ,									\
-			sizeof(* timers-> names ) * new_size);												\
-		assert_not_null(timers-> names);														\
-																								\
-		timers-> names##_size = new_size;														\
-	}																							\
+	bool status = alloc_vec_resize(&timers-> names##_vec ,										\
+		timers-> names##_used + count);															\
+	assert_true(status);																		\
 }																								\
 																								\
 																								\
@@ -878,13 +870,15 @@ time_timers_init(
 	time_timers_t timers = alloc_malloc(sizeof(*timers));
 	assert_not_null(timers);
 
-	timers->timeouts = NULL;
+	alloc_vec_init(&timers->timeouts_vec,
+		sizeof(*timers->timeouts), TIME_TIMERS_MAX_COUNT);
+	timers->timeouts = timers->timeouts_vec.data;
 	timers->timeouts_used = 1;
-	timers->timeouts_size = 0;
 
-	timers->intervals = NULL;
+	alloc_vec_init(&timers->intervals_vec,
+		sizeof(*timers->intervals), TIME_TIMERS_MAX_COUNT);
+	timers->intervals = timers->intervals_vec.data;
 	timers->intervals_used = 1;
-	timers->intervals_size = 0;
 
 	atomic_init(&timers->latest, 0);
 
@@ -900,6 +894,7 @@ time_timers_init(
 		.data = timers
 	};
 	thread_init(&timers->thread, data);
+	thread_set_name(timers->thread, "timers");
 
 	return timers;
 }
@@ -1927,6 +1927,7 @@ vk_init_window(
 		.data = vk
 	};
 	thread_init(&vk->window_thread, thread_data);
+	thread_set_name(vk->window_thread, "window");
 }
 
 
@@ -138,6 +138,51 @@ window_sdl_free(
 }
 
 
+typedef union window_user_event_data
+{
+	window_user_event_window_init_data_t window_init;
+	window_user_event_set_cursor_data_t set_cursor;
+	window_user_event_set_clipboard_data_t set_clipboard;
+}
+window_user_event_data_t;
+
+
+private alloc_pool_t window_user_event_pool =
+	ALLOC_POOL_INIT(window_user_event_data_t, ALLOC_POOL_FLAG_THREAD_CACHE);
+
+
+private void*
+window_user_event_data_alloc_fn(
+	alloc_t size
+	)
+{
+	if(!size)
+	{
+		return NULL;
+	}
+
+	return alloc_pool_alloc(&window_user_event_pool, 0);
+}
+
+
+#define window_user_event_data_alloc(size)							\
+({																	\
+	static_assert((size) <= sizeof(window_user_event_data_t),		\
+		"user event data does not fit the event pool");				\
+																	\
+	window_user_event_data_alloc_fn(size);							\
+})
+
+
+private void
+window_user_event_data_free(
+	void* data
+	)
+{
+	alloc_pool_release(&window_user_event_pool, data);
+}
+
+
 struct window
 {
 	window_manager_t manager;
@@ -149,7 +194,7 @@ struct window
 	SDL_Window* sdl_window;
 	SDL_PropertiesID props;
 
-	sync_mtx_t mtx;
+	sync_seqlock_t info_lock;
 
 	window_info_t info;
 
@@ -180,6 +225,8 @@ window_free_once_fn(
 	event_target_free(&window->event_table.move_target);
 	event_target_free(&window->event_table.free_target);
 	event_target_free(&window->event_table.init_target);
+
+	sync_seqlock_free(&window->info_lock);
 }
 
 
@@ -191,6 +238,8 @@ window_init(
 	window_t window = alloc_malloc(sizeof(*window));
 	assert_not_null(window);
 
+	sync_seqlock_init(&window->info_lock);
+
 	event_target_init(&window->event_table.init_target);
 	event_target_init(&window->event_table.free_target);
 	event_target_init(&window->event_table.move_target);
@@ -247,7 +296,7 @@ window_close(
 {
 	assert_not_null(window);
 
-	window_user_event_window_close_data_t* data = alloc_malloc(sizeof(*data));
+	window_user_event_window_close_data_t* data = window_user_event_data_alloc(sizeof(*data));
 	assert_ptr(data, sizeof(*data));
 
 	*data =
@@ -310,7 +359,7 @@ window_set_cursor(
 	assert_ge(cursor, 0);
 	assert_lt(cursor, WINDOW_CURSOR__COUNT);
 
-	window_user_event_set_cursor_data_t* data = alloc_malloc(sizeof(*data));
+	window_user_event_set_cursor_data_t* data = window_user_event_data_alloc(sizeof(*data));
 	assert_ptr(data, sizeof(*data));
 
 	*data =
@@ -330,7 +379,7 @@ window_show(
 {
 	assert_not_null(window);
 
-	window_user_event_show_window_data_t* data = alloc_malloc(sizeof(*data));
+	window_user_event_show_window_data_t* data = window_user_event_data_alloc(sizeof(*data));
 	assert_ptr(data, sizeof(*data));
 
 	*data =
@@ -349,7 +398,7 @@ window_hide(
 {
 	assert_not_null(window);
 
-	window_user_event_hide_window_data_t* data = alloc_malloc(sizeof(*data));
+	window_user_event_hide_window_data_t* data = window_user_event_data_alloc(sizeof(*data));
 	assert_ptr(data, sizeof(*data));
 
 	*data =
@@ -368,7 +417,7 @@ window_start_typing(
 {
 	assert_not_null(window);
 
-	window_user_event_start_typing_data_t* data = alloc_malloc(sizeof(*data));
+	window_user_event_start_typing_data_t* data = window_user_event_data_alloc(sizeof(*data));
 	assert_ptr(data, sizeof(*data));
 
 	*data =
@@ -387,7 +436,7 @@ window_stop_typing(
 {
 	assert_not_null(window);
 
-	window_user_event_stop_typing_data_t* data = alloc_malloc(sizeof(*data));
+	window_user_event_stop_typing_data_t* data = window_user_event_data_alloc(sizeof(*data));
 	assert_ptr(data, sizeof(*data));
 
 	*data =
@@ -406,7 +455,7 @@ window_get_clipboard(
 {
 	assert_not_null(window);
 
-	window_user_event_get_clipboard_data_t* data = alloc_malloc(sizeof(*data));
+	window_user_event_get_clipboard_data_t* data = window_user_event_data_alloc(sizeof(*data));
 	assert_ptr(data, sizeof(*data));
 
 	*data =
@@ -426,7 +475,7 @@ window_set_clipboard(
 {
 	assert_not_null(window);
 
-	window_user_event_set_clipboard_data_t* data = alloc_malloc(sizeof(*data));
+	window_user_event_set_clipboard_data_t* data = window_user_event_data_alloc(sizeof(*data));
 	assert_ptr(data, sizeof(*data));
 
 	*data =
@@ -446,7 +495,7 @@ window_toggle_fullscreen(
 {
 	assert_not_null(window);
 
-	window_user_event_window_fullscreen_data_t* data = alloc_malloc(sizeof(*data));
+	window_user_event_window_fullscreen_data_t* data = window_user_event_data_alloc(sizeof(*data));
 	assert_ptr(data, sizeof(*data));
 
 	*data =
@@ -467,9 +516,7 @@ window_get_info(
 	assert_not_null(window);
 	assert_not_null(info);
 
-	sync_mtx_lock(&window->mtx);
-		*info = window->info;
-	sync_mtx_unlock(&window->mtx);
+	sync_seqlock_read(&window->info_lock, info, &window->info, sizeof(*info));
 }
 
 
@@ -554,9 +601,9 @@ window_process_event(
 			.new_pos = {{ event->window.data1, event->window.data2 }}
 		};
 
-		sync_mtx_lock(&window->mtx);
+		sync_seqlock_write_lock(&window->info_lock);
 			window->info.extent.pos = event_data.new_pos;
-		sync_mtx_unlock(&window->mtx);
+		sync_seqlock_write_unlock(&window->info_lock);
 
 		event_target_fire(&window->event_table.move_target, &event_data);
 
@@ -572,9 +619,9 @@ window_process_event(
 			.new_size = {{ event->window.data1, event->window.data2 }}
 		};
 
-		sync_mtx_lock(&window->mtx);
+		sync_seqlock_write_lock(&window->info_lock);
 			window->info.extent.size = event_data.new_size;
-		sync_mtx_unlock(&window->mtx);
+		sync_seqlock_write_unlock(&window->info_lock);
 
 		event_target_fire(&window->event_table.resize_target, &event_data);
 
@@ -701,9 +748,9 @@ window_process_event(
 			.new_pos = {{ event->motion.x, event->motion.y }}
 		};
 
-		sync_mtx_lock(&window->mtx);
+		sync_seqlock_write_lock(&window->info_lock);
 			window->info.mouse = event_data.new_pos;
-		sync_mtx_unlock(&window->mtx);
+		sync_seqlock_write_unlock(&window->info_lock);
 
 		event_target_fire(&window->event_table.mouse_move_target, &event_data);
 
@@ -816,7 +863,7 @@ window_manager_add(
 	manager->window_head = window;
 	++manager->window_count;
 
-	window_user_event_window_init_data_t* data = alloc_malloc(sizeof(*data));
+	window_user_event_window_init_data_t* data = window_user_event_data_alloc(sizeof(*data));
 	assert_ptr(data, sizeof(*data));
 
 	str_t title_str = str_init_copy_cstr(title);
@@ -1000,7 +1047,7 @@ window_manager_process_user_event(
 
 		alloc_free(data->history, sizeof(*data->history));
 		str_free(data->title);
-		alloc_free(data, sizeof(*data));
+		window_user_event_data_free(data);
 
 		break;
 	}
@@ -1028,7 +1075,7 @@ window_manager_process_user_event(
 			window_manager_stop_running(manager);
 		}
 
-		alloc_free(data, sizeof(*data));
+		window_user_event_data_free(data);
 
 		break;
 	}
@@ -1039,7 +1086,7 @@ window_manager_process_user_event(
 
 		window_free(window);
 
-		window_user_event_window_free_data_t* free_data = alloc_malloc(sizeof(*free_data));
+		window_user_event_window_free_data_t* free_data = window_user_event_data_alloc(sizeof(*free_data));
 		assert_ptr(free_data, sizeof(*free_data));
 
 		*free_data =
@@ -1048,7 +1095,7 @@ window_manager_process_user_event(
 		};
 		window_push_event(window, WINDOW_USER_EVENT_WINDOW_FREE, free_data);
 
-		alloc_free(data, sizeof(*data));
+		window_user_event_data_free(data);
 
 		break;
 	}
@@ -1057,9 +1104,9 @@ window_manager_process_user_event(
 	{
 		window_user_event_window_fullscreen_data_t* data = event_data;
 
-		sync_mtx_lock(&window->mtx);
+		sync_seqlock_write_lock(&window->info_lock);
 		window->info.fullscreen = !window->info.fullscreen;
-		sync_mtx_unlock(&window->mtx);
+		sync_seqlock_write_unlock(&window->info_lock);
 
 		if(window->info.fullscreen)
 		{
@@ -1067,24 +1114,28 @@ window_manager_process_user_event(
 			bool status = SDL_GetWindowSize(window->sdl_window, &old_size.w, &old_size.h);
 			hard_assert_true(status, window_sdl_log_error());
 
-			window->info.old_extent.size =
-			(pair_t)
-			{
-				.w = old_size.w,
-				.h = old_size.h
-			};
+			sync_seqlock_write_lock(&window->info_lock);
+				window->info.old_extent.size =
+				(pair_t)
+				{
+					.w = old_size.w,
+					.h = old_size.h
+				};
+			sync_seqlock_write_unlock(&window->info_lock);
 
 
 			ipair_t old_pos;
 			status = SDL_GetWindowPosition(window->sdl_window, &old_pos.x, &old_pos.y);
 			hard_assert_true(status, window_sdl_log_error());
 
-			window->info.old_extent.pos =
-			(pair_t)
-			{
-				.x = old_pos.x,
-				.y = old_pos.y
-			};
+			sync_seqlock_write_lock(&window->info_lock);
+				window->info.old_extent.pos =
+				(pair_t)
+				{
+					.x = old_pos.x,
+					.y = old_pos.y
+				};
+			sync_seqlock_write_unlock(&window->info_lock);
 
 
 			status = SDL_SetWindowFullscreen(window->sdl_window, true);
@@ -1111,7 +1162,7 @@ window_manager_process_user_event(
 		};
 		event_target_fire(&window->event_table.fullscreen_target, &event_data);
 
-		alloc_free(data, sizeof(*data));
+		window_user_event_data_free(data);
 
 		break;
 	}
@@ -1128,7 +1179,7 @@ window_manager_process_user_event(
 			SDL_SetCursor(manager->cursors[data->cursor]);
 		}
 
-		alloc_free(data, sizeof(*data));
+		window_user_event_data_free(data);
 
 		break;
 	}
@@ -1140,7 +1191,7 @@ window_manager_process_user_event(
 		bool status = SDL_ShowWindow(window->sdl_window);
 		hard_assert_true(status, window_sdl_log_error());
 
-		alloc_free(data, sizeof(*data));
+		window_user_event_data_free(data);
 
 		break;
 	}
@@ -1152,7 +1203,7 @@ window_manager_process_user_event(
 		bool status = SDL_HideWindow(window->sdl_window);
 		hard_assert_true(status, window_sdl_log_error());
 
-		alloc_free(data, sizeof(*data));
+		window_user_event_data_free(data);
 
 		break;
 	}
@@ -1164,7 +1215,7 @@ window_manager_process_user_event(
 		bool status = SDL_StartTextInput(window->sdl_window);
 		hard_assert_true(status, window_sdl_log_error());
 
-		alloc_free(data, sizeof(*data));
+		window_user_event_data_free(data);
 
 		break;
 	}
@@ -1176,7 +1227,7 @@ window_manager_process_user_event(
 		bool status = SDL_StopTextInput(window->sdl_window);
 		hard_assert_true(status, window_sdl_log_error());
 
-		alloc_free(data, sizeof(*data));
+		window_user_event_data_free(data);
 
 		break;
 	}
@@ -1198,7 +1249,7 @@ window_manager_process_user_event(
 		};
 		event_target_fire(&window->event_table.set_clipboard_target, &event_data);
 
-		alloc_free(data, sizeof(*data));
+		window_user_event_data_free(data);
 
 		break;
 	}
@@ -1225,7 +1276,7 @@ window_manager_process_user_event(
 			SDL_free(text);
 		}
 
-		alloc_free(data, sizeof(*data));
+		window_user_event_data_free(data);
 
 		break;
 	}
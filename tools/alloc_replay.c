@@ -0,0 +1,1003 @@
+/*
+ *   Copyright 2025 Franciszek Balcerak
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <thesis/debug.h>
+#include <thesis/threads.h>
+#include <thesis/alloc_ext.h>
+
+#include <time.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <stdatomic.h>
+#include <sys/resource.h>
+
+
+typedef struct replay_allocator
+{
+	const char* name;
+
+	void*
+	(*alloc_fn)(
+		alloc_t size,
+		int zero
+		);
+
+	void
+	(*free_fn)(
+		void* ptr,
+		alloc_t size
+		);
+
+	void*
+	(*realloc_fn)(
+		void* ptr,
+		alloc_t old_size,
+		alloc_t new_size
+		);
+}
+replay_allocator_t;
+
+
+private void*
+replay_alloc_alloc(
+	alloc_t size,
+	int zero
+	)
+{
+	return alloc_alloc(size, zero);
+}
+
+
+private void
+replay_alloc_free(
+	void* ptr,
+	alloc_t size
+	)
+{
+	alloc_free(ptr, size);
+}
+
+
+private void*
+replay_alloc_realloc(
+	void* ptr,
+	alloc_t old_size,
+	alloc_t new_size
+	)
+{
+	return alloc_realloc(ptr, old_size, new_size, 0);
+}
+
+
+private void*
+replay_malloc_alloc(
+	alloc_t size,
+	int zero
+	)
+{
+	return zero ? calloc(1, size) : malloc(size);
+}
+
+
+private void
+replay_malloc_free(
+	void* ptr,
+	alloc_t size
+	)
+{
+	(void) size;
+
+	free(ptr);
+}
+
+
+private void*
+replay_malloc_realloc(
+	void* ptr,
+	alloc_t old_size,
+	alloc_t new_size
+	)
+{
+	(void) old_size;
+
+	return realloc(ptr, new_size);
+}
+
+
+private const replay_allocator_t replay_allocators[] =
+{
+	{
+		.name = "alloc",
+		.alloc_fn = replay_alloc_alloc,
+		.free_fn = replay_alloc_free,
+		.realloc_fn = replay_alloc_realloc
+	},
+	{
+		.name = "malloc",
+		.alloc_fn = replay_malloc_alloc,
+		.free_fn = replay_malloc_free,
+		.realloc_fn = replay_malloc_realloc
+	},
+};
+
+
+typedef enum replay_op_type : uint32_t
+{
+	REPLAY_OP_ALLOC,
+	REPLAY_OP_CALLOC,
+	REPLAY_OP_FREE,
+	REPLAY_OP_REALLOC,
+}
+replay_op_type_t;
+
+
+typedef struct replay_op
+{
+	replay_op_type_t type;
+	uint32_t id;
+	uint32_t old_id;
+	alloc_t size;
+	alloc_t old_size;
+}
+replay_op_t;
+
+
+typedef struct replay_thread
+{
+	replay_op_t* ops;
+	uint32_t op_count;
+	uint32_t op_capacity;
+
+	uint32_t* latencies;
+	uint32_t pending_id;
+	alloc_t pending_size;
+}
+replay_thread_t;
+
+
+typedef struct replay_trace
+{
+	replay_thread_t* threads;
+	uint32_t thread_count;
+	uint32_t object_count;
+	uint64_t op_count;
+}
+replay_trace_t;
+
+
+typedef struct replay_result
+{
+	uint64_t time;
+	uint64_t op_count;
+	uint64_t failed;
+	uint64_t percentiles[5];
+	uint64_t base_rss;
+}
+replay_result_t;
+
+
+typedef struct replay_map_entry
+{
+	uint64_t ptr;
+	uint32_t id;
+}
+replay_map_entry_t;
+
+
+typedef struct replay_map
+{
+	replay_map_entry_t* entries;
+	uint64_t mask;
+}
+replay_map_t;
+
+
+private const double replay_percentiles[] = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+
+
+#define REPLAY_FAILED ((void*) 1)
+
+
+private uint64_t
+replay_get_time(
+	void
+	)
+{
+	struct timespec time;
+	int status = clock_gettime(CLOCK_MONOTONIC, &time);
+	hard_assert_eq(status, 0);
+
+	return time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+
+private uint64_t
+replay_get_rss(
+	void
+	)
+{
+	FILE* file = fopen("/proc/self/statm", "r");
+	if(!file)
+	{
+		return 0;
+	}
+
+	unsigned long size = 0;
+	unsigned long resident = 0;
+
+	if(fscanf(file, "%lu %lu", &size, &resident) != 2)
+	{
+		resident = 0;
+	}
+
+	(void) fclose(file);
+
+	return resident * sysconf(_SC_PAGESIZE);
+}
+
+
+private uint64_t
+replay_hash(
+	uint64_t ptr
+	)
+{
+	ptr ^= ptr >> 33;
+	ptr *= 0xFF51AFD7ED558CCDULL;
+	ptr ^= ptr >> 33;
+
+	return ptr;
+}
+
+
+private void
+replay_map_init(
+	replay_map_t* map,
+	uint64_t count
+	)
+{
+	uint64_t capacity = 16;
+	while(capacity < count * 2)
+	{
+		capacity <<= 1;
+	}
+
+	map->entries = calloc(capacity, sizeof(*map->entries));
+	hard_assert_not_null(map->entries);
+
+	map->mask = capacity - 1;
+}
+
+
+private void
+replay_map_free(
+	replay_map_t* map
+	)
+{
+	free(map->entries);
+}
+
+
+private void
+replay_map_set(
+	replay_map_t* map,
+	uint64_t ptr,
+	uint32_t id
+	)
+{
+	uint64_t idx = replay_hash(ptr) & map->mask;
+
+	while(map->entries[idx].ptr && map->entries[idx].ptr != ptr)
+	{
+		idx = (idx + 1) & map->mask;
+	}
+
+	map->entries[idx].ptr = ptr;
+	map->entries[idx].id = id;
+}
+
+
+private bool
+replay_map_pop(
+	replay_map_t* map,
+	uint64_t ptr,
+	uint32_t* id
+	)
+{
+	uint64_t idx = replay_hash(ptr) & map->mask;
+
+	while(map->entries[idx].ptr != ptr)
+	{
+		if(!map->entries[idx].ptr)
+		{
+			return false;
+		}
+
+		idx = (idx + 1) & map->mask;
+	}
+
+	*id = map->entries[idx].id;
+
+	uint64_t hole = idx;
+
+	while(1)
+	{
+		idx = (idx + 1) & map->mask;
+
+		replay_map_entry_t* entry = &map->entries[idx];
+		if(!entry->ptr)
+		{
+			break;
+		}
+
+		uint64_t home = replay_hash(entry->ptr) & map->mask;
+
+		if(((idx - home) & map->mask) >= ((idx - hole) & map->mask))
+		{
+			map->entries[hole] = *entry;
+			hole = idx;
+		}
+	}
+
+	map->entries[hole].ptr = 0;
+
+	return true;
+}
+
+
+private int
+replay_record_cmp(
+	const void* a,
+	const void* b
+	)
+{
+	const alloc_trace_record_t* record_a = a;
+	const alloc_trace_record_t* record_b = b;
+
+	if(record_a->time != record_b->time)
+	{
+		return record_a->time < record_b->time ? -1 : 1;
+	}
+
+	return record_a->thread < record_b->thread ? -1 : record_a->thread > record_b->thread;
+}
+
+
+private int
+replay_latency_cmp(
+	const void* a,
+	const void* b
+	)
+{
+	uint32_t latency_a = *(const uint32_t*) a;
+	uint32_t latency_b = *(const uint32_t*) b;
+
+	return latency_a < latency_b ? -1 : latency_a > latency_b;
+}
+
+
+private void
+replay_add_op(
+	replay_thread_t* thread,
+	replay_op_t op
+	)
+{
+	if(thread->op_count == thread->op_capacity)
+	{
+		thread->op_capacity = thread->op_capacity ? thread->op_capacity << 1 : 1024;
+		thread->ops = realloc(thread->ops, sizeof(*thread->ops) * thread->op_capacity);
+		hard_assert_not_null(thread->ops);
+	}
+
+	thread->ops[thread->op_count++] = op;
+}
+
+
+private bool
+replay_load(
+	replay_trace_t* trace,
+	const char* path,
+	uint32_t max_threads
+	)
+{
+	FILE* file = fopen(path, "rb");
+	if(!file)
+	{
+		fprintf(stderr, "Could not open trace \"%s\"\n", path);
+		return false;
+	}
+
+	alloc_trace_header_t header;
+
+	if(
+		fread(&header, sizeof(header), 1, file) != 1 ||
+		header.magic != ALLOC_TRACE_MAGIC ||
+		header.version != ALLOC_TRACE_VERSION
+		)
+	{
+		fprintf(stderr, "\"%s\" is not a version %u allocation trace\n",
+			path, ALLOC_TRACE_VERSION);
+		(void) fclose(file);
+		return false;
+	}
+
+	uint64_t record_count = 0;
+	uint64_t record_capacity = 1 << 16;
+	alloc_trace_record_t* records = malloc(sizeof(*records) * record_capacity);
+	hard_assert_not_null(records);
+
+	while(1)
+	{
+		if(record_count == record_capacity)
+		{
+			record_capacity <<= 1;
+			records = realloc(records, sizeof(*records) * record_capacity);
+			hard_assert_not_null(records);
+		}
+
+		uint64_t read = fread(records + record_count, sizeof(*records),
+			record_capacity - record_count, file);
+		if(!read)
+		{
+			break;
+		}
+
+		record_count += read;
+	}
+
+	(void) fclose(file);
+
+	uint32_t thread_count = 0;
+
+	for(uint64_t i = 0; i < record_count; ++i)
+	{
+		thread_count = MACRO_MAX(thread_count, records[i].thread + 1);
+	}
+
+	uint64_t* last_times = calloc(MACRO_MAX(thread_count, 1), sizeof(*last_times));
+	hard_assert_not_null(last_times);
+
+	for(uint64_t i = 0; i < record_count; ++i)
+	{
+		alloc_trace_record_t* record = &records[i];
+		uint64_t* last_time = &last_times[record->thread];
+
+		if(*last_time && record->time <= *last_time)
+		{
+			record->time = *last_time + 1;
+		}
+
+		*last_time = record->time;
+	}
+
+	free(last_times);
+
+	qsort(records, record_count, sizeof(*records), replay_record_cmp);
+
+	if(max_threads)
+	{
+		thread_count = MACRO_MIN(thread_count, max_threads);
+	}
+
+	trace->threads = calloc(MACRO_MAX(thread_count, 1), sizeof(*trace->threads));
+	hard_assert_not_null(trace->threads);
+
+	trace->thread_count = thread_count;
+	trace->object_count = 0;
+	trace->op_count = 0;
+
+	replay_map_t map;
+	replay_map_init(&map, record_count);
+
+	for(uint64_t i = 0; i < record_count; ++i)
+	{
+		alloc_trace_record_t* record = &records[i];
+		replay_thread_t* thread = &trace->threads[record->thread % thread_count];
+
+		switch(record->op)
+		{
+
+		case ALLOC_TRACE_OP_ALLOC:
+		case ALLOC_TRACE_OP_CALLOC:
+		{
+			uint32_t id = ++trace->object_count;
+			replay_map_set(&map, record->ptr, id);
+
+			if(thread->pending_id)
+			{
+				replay_add_op(thread,
+					(replay_op_t)
+					{
+						.type = REPLAY_OP_REALLOC,
+						.id = id,
+						.old_id = thread->pending_id,
+						.size = record->size,
+						.old_size = thread->pending_size
+					}
+					);
+
+				thread->pending_id = 0;
+			}
+			else
+			{
+				replay_add_op(thread,
+					(replay_op_t)
+					{
+						.type = record->op == ALLOC_TRACE_OP_CALLOC
+							? REPLAY_OP_CALLOC : REPLAY_OP_ALLOC,
+						.id = id,
+						.size = record->size
+					}
+					);
+			}
+
+			break;
+		}
+
+		case ALLOC_TRACE_OP_FREE:
+		case ALLOC_TRACE_OP_REALLOC:
+		{
+			uint32_t id;
+			if(!replay_map_pop(&map, record->ptr, &id))
+			{
+				break;
+			}
+
+			if(record->op == ALLOC_TRACE_OP_REALLOC)
+			{
+				thread->pending_id = id;
+				thread->pending_size = record->size;
+				break;
+			}
+
+			replay_add_op(thread,
+				(replay_op_t)
+				{
+					.type = REPLAY_OP_FREE,
+					.id = id,
+					.size = record->size
+				}
+				);
+
+			break;
+		}
+
+		case ALLOC_TRACE_OP_REALLOC_FAIL:
+		{
+			if(thread->pending_id)
+			{
+				replay_map_set(&map, record->ptr, thread->pending_id);
+				thread->pending_id = 0;
+			}
+
+			break;
+		}
+
+		default: break;
+
+		}
+	}
+
+	replay_map_free(&map);
+	free(records);
+
+	for(uint32_t i = 0; i < thread_count; ++i)
+	{
+		replay_thread_t* thread = &trace->threads[i];
+
+		thread->latencies = malloc(sizeof(*thread->latencies) * MACRO_MAX(thread->op_count, 1));
+		hard_assert_not_null(thread->latencies);
+
+		trace->op_count += thread->op_count;
+	}
+
+	return true;
+}
+
+
+private void
+replay_free(
+	replay_trace_t* trace
+	)
+{
+	for(uint32_t i = 0; i < trace->thread_count; ++i)
+	{
+		free(trace->threads[i].ops);
+		free(trace->threads[i].latencies);
+	}
+
+	free(trace->threads);
+}
+
+
+typedef struct replay_context
+{
+	const replay_allocator_t* allocator;
+	replay_thread_t* thread;
+	void* _Atomic * objects;
+	_Atomic uint32_t* ready;
+	_Atomic uint64_t* failed;
+	uint32_t thread_count;
+	uint32_t page_size;
+}
+replay_context_t;
+
+
+private void*
+replay_wait_object(
+	void* _Atomic * object
+	)
+{
+	void* ptr;
+
+	while(!(ptr = atomic_load_explicit(object, memory_order_acquire)))
+	{
+		(void) sched_yield();
+	}
+
+	return ptr;
+}
+
+
+private void
+replay_touch(
+	uint8_t* ptr,
+	alloc_t size,
+	uint32_t page_size
+	)
+{
+	for(alloc_t offset = 0; offset < size; offset += page_size)
+	{
+		ptr[offset] = 1;
+	}
+}
+
+
+private void
+replay_thread_fn(
+	void* data
+	)
+{
+	replay_context_t* context = data;
+	const replay_allocator_t* allocator = context->allocator;
+	replay_thread_t* thread = context->thread;
+	void* _Atomic * objects = context->objects;
+
+	atomic_fetch_add_explicit(context->ready, 1, memory_order_acq_rel);
+
+	while(atomic_load_explicit(context->ready, memory_order_acquire) <= context->thread_count)
+	{
+		(void) sched_yield();
+	}
+
+	uint64_t failed = 0;
+
+	for(uint32_t i = 0; i < thread->op_count; ++i)
+	{
+		replay_op_t* op = &thread->ops[i];
+		void* ptr = NULL;
+		uint64_t time = 0;
+
+		switch(op->type)
+		{
+
+		case REPLAY_OP_ALLOC:
+		case REPLAY_OP_CALLOC:
+		{
+			time = replay_get_time();
+			ptr = allocator->alloc_fn(op->size, op->type == REPLAY_OP_CALLOC);
+			time = replay_get_time() - time;
+
+			break;
+		}
+
+		case REPLAY_OP_FREE:
+		{
+			void* old_ptr = replay_wait_object(&objects[op->id]);
+			if(old_ptr == REPLAY_FAILED)
+			{
+				break;
+			}
+
+			time = replay_get_time();
+			allocator->free_fn(old_ptr, op->size);
+			time = replay_get_time() - time;
+
+			break;
+		}
+
+		case REPLAY_OP_REALLOC:
+		{
+			void* old_ptr = replay_wait_object(&objects[op->old_id]);
+			if(old_ptr == REPLAY_FAILED)
+			{
+				old_ptr = NULL;
+			}
+
+			time = replay_get_time();
+			ptr = allocator->realloc_fn(old_ptr, op->old_size, op->size);
+			time = replay_get_time() - time;
+
+			break;
+		}
+
+		default: assert_unreachable();
+
+		}
+
+		thread->latencies[i] = MACRO_MIN(time, UINT32_MAX);
+
+		if(op->type == REPLAY_OP_FREE)
+		{
+			continue;
+		}
+
+		if(!ptr)
+		{
+			++failed;
+			ptr = REPLAY_FAILED;
+		}
+		else
+		{
+			replay_touch(ptr, op->size, context->page_size);
+		}
+
+		atomic_store_explicit(&objects[op->id], ptr, memory_order_release);
+	}
+
+	atomic_fetch_add_explicit(context->failed, failed, memory_order_relaxed);
+}
+
+
+private void
+replay_run(
+	replay_trace_t* trace,
+	const replay_allocator_t* allocator,
+	replay_result_t* result
+	)
+{
+	result->base_rss = replay_get_rss();
+
+	void* _Atomic * objects = calloc(trace->object_count + 1, sizeof(*objects));
+	hard_assert_not_null(objects);
+
+	replay_context_t* contexts = calloc(trace->thread_count, sizeof(*contexts));
+	hard_assert_not_null(contexts);
+
+	thread_t* threads = calloc(trace->thread_count, sizeof(*threads));
+	hard_assert_not_null(threads);
+
+	_Atomic uint32_t ready = 0;
+	_Atomic uint64_t failed = 0;
+
+	for(uint32_t i = 0; i < trace->thread_count; ++i)
+	{
+		contexts[i] =
+		(replay_context_t)
+		{
+			.allocator = allocator,
+			.thread = &trace->threads[i],
+			.objects = objects,
+			.ready = &ready,
+			.failed = &failed,
+			.thread_count = trace->thread_count,
+			.page_size = sysconf(_SC_PAGESIZE)
+		};
+
+		thread_init(&threads[i],
+			(thread_data_t)
+			{
+				.fn = replay_thread_fn,
+				.data = &contexts[i]
+			}
+			);
+	}
+
+	while(atomic_load_explicit(&ready, memory_order_acquire) < trace->thread_count)
+	{
+		(void) sched_yield();
+	}
+
+	uint64_t time = replay_get_time();
+	atomic_fetch_add_explicit(&ready, 1, memory_order_acq_rel);
+
+	for(uint32_t i = 0; i < trace->thread_count; ++i)
+	{
+		thread_join(threads[i]);
+	}
+
+	result->time = replay_get_time() - time;
+	result->op_count = trace->op_count;
+	result->failed = atomic_load_explicit(&failed, memory_order_relaxed);
+
+	uint32_t* latencies = malloc(sizeof(*latencies) * MACRO_MAX(trace->op_count, 1));
+	hard_assert_not_null(latencies);
+
+	uint64_t count = 0;
+
+	for(uint32_t i = 0; i < trace->thread_count; ++i)
+	{
+		replay_thread_t* thread = &trace->threads[i];
+
+		(void) memcpy(latencies + count, thread->latencies,
+			sizeof(*latencies) * thread->op_count);
+		count += thread->op_count;
+	}
+
+	qsort(latencies, count, sizeof(*latencies), replay_latency_cmp);
+
+	for(uint32_t i = 0; i < MACRO_ARRAY_LEN(replay_percentiles); ++i)
+	{
+		uint64_t idx = count ? (count - 1) * replay_percentiles[i] : 0;
+		result->percentiles[i] = count ? latencies[idx] : 0;
+	}
+
+	free(latencies);
+	free(threads);
+	free(contexts);
+}
+
+
+private const replay_allocator_t*
+replay_find_allocator(
+	const char* name
+	)
+{
+	for(uint32_t i = 0; i < MACRO_ARRAY_LEN(replay_allocators); ++i)
+	{
+		if(!strcmp(replay_allocators[i].name, name))
+		{
+			return &replay_allocators[i];
+		}
+	}
+
+	return NULL;
+}
+
+
+private bool
+replay_allocator(
+	replay_trace_t* trace,
+	const replay_allocator_t* allocator
+	)
+{
+	replay_result_t* result = mmap(NULL, sizeof(*result),
+		PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	hard_assert_neq(result, MAP_FAILED);
+
+	(void) fflush(stdout);
+
+	pid_t pid = fork();
+	hard_assert_neq(pid, -1);
+
+	if(!pid)
+	{
+		replay_run(trace, allocator, result);
+		_exit(0);
+	}
+
+	int status;
+	struct rusage usage;
+
+	pid_t waited = wait4(pid, &status, 0, &usage);
+	hard_assert_eq(waited, pid);
+
+	if(!WIFEXITED(status) || WEXITSTATUS(status))
+	{
+		printf("%-10s replay crashed\n", allocator->name);
+		(void) munmap(result, sizeof(*result));
+		return false;
+	}
+
+	double seconds = result->time / 1e9;
+	double peak_rss = usage.ru_maxrss / 1024.0;
+	double base_rss = result->base_rss / 1048576.0;
+
+	printf("%-10s %12" PRIu64 " %10.2f %10.2f %8" PRIu64 " %8" PRIu64 " %8" PRIu64
+		" %8" PRIu64 " %10" PRIu64 " %10.2f %10.2f\n",
+		allocator->name, result->op_count, seconds * 1e3,
+		seconds ? result->op_count / seconds / 1e6 : 0.0,
+		result->percentiles[0], result->percentiles[1], result->percentiles[2],
+		result->percentiles[3], result->percentiles[4],
+		peak_rss, peak_rss - base_rss);
+
+	if(result->failed)
+	{
+		printf("%-10s %" PRIu64 " allocations failed\n", "", result->failed);
+	}
+
+	(void) munmap(result, sizeof(*result));
+	return true;
+}
+
+
+int
+main(
+	int argc,
+	char** argv
+	)
+{
+	if(argc < 2)
+	{
+		fprintf(stderr,
+			"Usage: %s <trace> [-t max threads] [allocator...]\n"
+			"Allocators:", argv[0]);
+
+		for(uint32_t i = 0; i < MACRO_ARRAY_LEN(replay_allocators); ++i)
+		{
+			fprintf(stderr, " %s", replay_allocators[i].name);
+		}
+
+		fprintf(stderr, "\n");
+		return 1;
+	}
+
+	uint32_t max_threads = 0;
+	int first_allocator = 2;
+
+	if(argc >= 4 && !strcmp(argv[2], "-t"))
+	{
+		max_threads = strtoul(argv[3], NULL, 10);
+		first_allocator = 4;
+	}
+
+	replay_trace_t trace;
+	if(!replay_load(&trace, argv[1], max_threads))
+	{
+		return 1;
+	}
+
+	printf("%" PRIu32 " threads, %" PRIu32 " objects, %" PRIu64 " operations\n\n",
+		trace.thread_count, trace.object_count, trace.op_count);
+
+	printf("%-10s %12s %10s %10s %8s %8s %8s %8s %10s %10s %10s\n",
+		"allocator", "ops", "time ms", "Mops/s", "p50 ns", "p90 ns",
+		"p99 ns", "p99.9 ns", "max ns", "peak MiB", "delta MiB");
+
+	bool success = true;
+
+	if(first_allocator >= argc)
+	{
+		for(uint32_t i = 0; i < MACRO_ARRAY_LEN(replay_allocators); ++i)
+		{
+			success &= replay_allocator(&trace, &replay_allocators[i]);
+		}
+	}
+	else
+	{
+		for(int i = first_allocator; i < argc; ++i)
+		{
+			const replay_allocator_t* allocator = replay_find_allocator(argv[i]);
+			if(!allocator)
+			{
+				fprintf(stderr, "Unknown allocator \"%s\"\n", argv[i]);
+				success = false;
+				continue;
+			}
+
+			success &= replay_allocator(&trace, allocator);
+		}
+	}
+
+	replay_free(&trace);
+
+	return !success;
+}
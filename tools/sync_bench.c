@@ -0,0 +1,310 @@
+/*
+ *   Copyright 2025 Franciszek Balcerak
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <thesis/debug.h>
+#include <thesis/threads.h>
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
+
+
+#define BENCH_ROUNDS 3
+
+
+typedef struct bench_state
+{
+	pthread_mutex_t pthread_mtx;
+	sync_mtx_t mtx;
+
+	sem_t pthread_sems[2];
+	sync_sem_t sems[2];
+
+	uint64_t op_count;
+	uint64_t counter;
+}
+bench_state_t;
+
+
+typedef struct bench_impl
+{
+	const char* name;
+
+	void
+	(*mtx_fn)(
+		bench_state_t* state
+		);
+
+	void
+	(*sem_fn)(
+		bench_state_t* state,
+		uint32_t index
+		);
+}
+bench_impl_t;
+
+
+typedef struct bench_thread
+{
+	bench_state_t* state;
+	const bench_impl_t* impl;
+	uint32_t index;
+}
+bench_thread_t;
+
+
+private uint64_t
+bench_get_time(
+	void
+	)
+{
+	struct timespec time;
+	int status = clock_gettime(CLOCK_MONOTONIC, &time);
+	hard_assert_eq(status, 0);
+
+	return time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+
+private void
+bench_pthread_mtx_fn(
+	bench_state_t* state
+	)
+{
+	for(uint64_t i = 0; i < state->op_count; ++i)
+	{
+		(void) pthread_mutex_lock(&state->pthread_mtx);
+			++state->counter;
+		(void) pthread_mutex_unlock(&state->pthread_mtx);
+	}
+}
+
+
+private void
+bench_sync_mtx_fn(
+	bench_state_t* state
+	)
+{
+	for(uint64_t i = 0; i < state->op_count; ++i)
+	{
+		sync_mtx_lock(&state->mtx);
+			++state->counter;
+		sync_mtx_unlock(&state->mtx);
+	}
+}
+
+
+private void
+bench_pthread_sem_fn(
+	bench_state_t* state,
+	uint32_t index
+	)
+{
+	for(uint64_t i = 0; i < state->op_count; ++i)
+	{
+		if(index)
+		{
+			while(sem_wait(&state->pthread_sems[1]));
+			(void) sem_post(&state->pthread_sems[0]);
+		}
+		else
+		{
+			(void) sem_post(&state->pthread_sems[1]);
+			while(sem_wait(&state->pthread_sems[0]));
+		}
+	}
+}
+
+
+private void
+bench_sync_sem_fn(
+	bench_state_t* state,
+	uint32_t index
+	)
+{
+	for(uint64_t i = 0; i < state->op_count; ++i)
+	{
+		if(index)
+		{
+			sync_sem_wait(&state->sems[1]);
+			sync_sem_post(&state->sems[0]);
+		}
+		else
+		{
+			sync_sem_post(&state->sems[1]);
+			sync_sem_wait(&state->sems[0]);
+		}
+	}
+}
+
+
+private const bench_impl_t bench_impls[] =
+{
+	{
+		.name = "pthread",
+		.mtx_fn = bench_pthread_mtx_fn,
+		.sem_fn = bench_pthread_sem_fn
+	},
+	{
+		.name = "sync",
+		.mtx_fn = bench_sync_mtx_fn,
+		.sem_fn = bench_sync_sem_fn
+	}
+};
+
+
+private void
+bench_mtx_thread_fn(
+	void* data
+	)
+{
+	bench_thread_t* thread = data;
+
+	thread->impl->mtx_fn(thread->state);
+}
+
+
+private void
+bench_sem_thread_fn(
+	void* data
+	)
+{
+	bench_thread_t* thread = data;
+
+	thread->impl->sem_fn(thread->state, thread->index);
+}
+
+
+private uint64_t
+bench_run(
+	const bench_impl_t* impl,
+	thread_fn_t fn,
+	uint64_t op_count,
+	uint32_t thread_count
+	)
+{
+	bench_state_t state;
+	state.op_count = op_count;
+	state.counter = 0;
+
+	int status = pthread_mutex_init(&state.pthread_mtx, NULL);
+	hard_assert_eq(status, 0);
+
+	sync_mtx_init(&state.mtx);
+
+	for(uint32_t i = 0; i < 2; ++i)
+	{
+		status = sem_init(&state.pthread_sems[i], 0, 0);
+		hard_assert_eq(status, 0);
+
+		sync_sem_init(&state.sems[i], 0);
+	}
+
+	thread_t threads[thread_count];
+	bench_thread_t thread_data[thread_count];
+
+	uint64_t start = bench_get_time();
+
+	for(uint32_t i = 0; i < thread_count; ++i)
+	{
+		thread_data[i] =
+		(bench_thread_t)
+		{
+			.state = &state,
+			.impl = impl,
+			.index = i
+		};
+
+		thread_init(&threads[i], (thread_data_t){ .fn = fn, .data = &thread_data[i] });
+	}
+
+	for(uint32_t i = 0; i < thread_count; ++i)
+	{
+		thread_join(threads[i]);
+	}
+
+	uint64_t time = bench_get_time() - start;
+
+	if(fn == bench_mtx_thread_fn)
+	{
+		hard_assert_eq(state.counter, op_count * thread_count);
+	}
+
+	for(uint32_t i = 0; i < 2; ++i)
+	{
+		sync_sem_free(&state.sems[i]);
+		(void) sem_destroy(&state.pthread_sems[i]);
+	}
+
+	sync_mtx_free(&state.mtx);
+	(void) pthread_mutex_destroy(&state.pthread_mtx);
+
+	return time;
+}
+
+
+private void
+bench_print(
+	const char* test,
+	thread_fn_t fn,
+	uint64_t op_count,
+	uint32_t thread_count
+	)
+{
+	for(uint32_t i = 0; i < MACRO_ARRAY_LEN(bench_impls); ++i)
+	{
+		uint64_t best = UINT64_MAX;
+
+		for(uint32_t round = 0; round < BENCH_ROUNDS; ++round)
+		{
+			best = MACRO_MIN(best, bench_run(&bench_impls[i],
+				fn, op_count, thread_count));
+		}
+
+		printf("%-8s %-10s %10.2f %10.2f\n", test, bench_impls[i].name,
+			best / 1e6, (double) best / (op_count * thread_count));
+	}
+}
+
+
+int
+main(
+	int argc,
+	char** argv
+	)
+{
+	uint64_t op_count = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+	uint32_t thread_count = argc > 2 ? strtoul(argv[2], NULL, 10) :
+		sysconf(_SC_NPROCESSORS_ONLN);
+
+	if(!op_count || !thread_count)
+	{
+		fprintf(stderr, "Usage: %s [ops] [threads]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%" PRIu64 " ops, %" PRIu32 " threads, SYNC_FUTEX=%d\n\n",
+		op_count, thread_count, SYNC_FUTEX);
+
+	printf("%-8s %-10s %10s %10s\n", "test", "impl", "time ms", "ns/op");
+
+	bench_print("mutex", bench_mtx_thread_fn, op_count, thread_count);
+	bench_print("sem", bench_sem_thread_fn, op_count / 10, 2);
+
+	return 0;
+}
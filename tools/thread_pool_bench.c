@@ -0,0 +1,401 @@
+/*
+ *   Copyright 2025 Franciszek Balcerak
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <thesis/debug.h>
+#include <thesis/threads.h>
+#include <thesis/alloc_ext.h>
+
+#include <time.h>
+#include <stdio.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+
+
+#define BENCH_ROUNDS 3
+#define BENCH_BATCH_SIZE 64
+
+
+typedef struct bench_queue
+{
+	sync_sem_t sem;
+	sync_mtx_t mtx;
+
+	alloc_vec_t queue;
+}
+bench_queue_t;
+
+
+typedef struct bench_state
+{
+	thread_pool_t pool;
+	bench_queue_t queue;
+
+	uint64_t task_count;
+	uint32_t producer_count;
+	uint64_t _Atomic done;
+}
+bench_state_t;
+
+
+typedef struct bench_impl
+{
+	const char* name;
+
+	void
+	(*init_fn)(
+		bench_state_t* state
+		);
+
+	void
+	(*free_fn)(
+		bench_state_t* state
+		);
+
+	void
+	(*add_fn)(
+		bench_state_t* state,
+		thread_data_t data
+		);
+
+	void
+	(*add_batch_fn)(
+		bench_state_t* state,
+		const thread_data_t* tasks,
+		alloc_t count
+		);
+
+	thread_fn_t worker_fn;
+}
+bench_impl_t;
+
+
+private uint64_t
+bench_get_time(
+	void
+	)
+{
+	struct timespec time;
+	int status = clock_gettime(CLOCK_MONOTONIC, &time);
+	hard_assert_eq(status, 0);
+
+	return time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+
+private void
+bench_task_fn(
+	void* data
+	)
+{
+	bench_state_t* state = data;
+
+	atomic_fetch_add_explicit(&state->done, 1, memory_order_relaxed);
+}
+
+
+private void
+bench_mutex_init(
+	bench_state_t* state
+	)
+{
+	bench_queue_t* queue = &state->queue;
+
+	sync_sem_init(&queue->sem, 0);
+	sync_mtx_init(&queue->mtx);
+
+	alloc_vec_init(&queue->queue, sizeof(thread_data_t), MACRO_POWER_OF_2(24));
+}
+
+
+private void
+bench_mutex_free(
+	bench_state_t* state
+	)
+{
+	bench_queue_t* queue = &state->queue;
+
+	alloc_vec_free(&queue->queue);
+
+	sync_mtx_free(&queue->mtx);
+	sync_sem_free(&queue->sem);
+}
+
+
+private void
+bench_mutex_add(
+	bench_state_t* state,
+	thread_data_t data
+	)
+{
+	bench_queue_t* queue = &state->queue;
+
+	sync_mtx_lock(&queue->mtx);
+		thread_data_t* task = alloc_vec_push(&queue->queue, 1);
+		assert_not_null(task);
+
+		*task = data;
+	sync_mtx_unlock(&queue->mtx);
+
+	sync_sem_post(&queue->sem);
+}
+
+
+private void
+bench_mutex_worker_fn(
+	void* data
+	)
+{
+	bench_state_t* state = data;
+	bench_queue_t* queue = &state->queue;
+
+	while(1)
+	{
+		sync_sem_wait(&queue->sem);
+
+		thread_async_off();
+		thread_cancel_off();
+
+		sync_mtx_lock(&queue->mtx);
+
+		thread_data_t* tasks = queue->queue.data;
+		thread_data_t task = *tasks;
+
+		if(queue->queue.count - 1)
+		{
+			(void) memmove(tasks, tasks + 1,
+				sizeof(*tasks) * (queue->queue.count - 1));
+		}
+
+		alloc_vec_pop(&queue->queue, 1);
+
+		sync_mtx_unlock(&queue->mtx);
+
+		task.fn(task.data);
+
+		thread_cancel_on();
+		thread_async_on();
+	}
+}
+
+
+private void
+bench_pool_init(
+	bench_state_t* state
+	)
+{
+	thread_pool_init(&state->pool);
+}
+
+
+private void
+bench_pool_free(
+	bench_state_t* state
+	)
+{
+	thread_pool_free(&state->pool);
+}
+
+
+private void
+bench_pool_add(
+	bench_state_t* state,
+	thread_data_t data
+	)
+{
+	thread_pool_add(&state->pool, data);
+}
+
+
+private void
+bench_pool_add_batch(
+	bench_state_t* state,
+	const thread_data_t* tasks,
+	alloc_t count
+	)
+{
+	thread_pool_add_batch(&state->pool, tasks, count);
+}
+
+
+private void
+bench_pool_worker_fn(
+	void* data
+	)
+{
+	bench_state_t* state = data;
+
+	thread_pool_fn(&state->pool);
+}
+
+
+private const bench_impl_t bench_impls[] =
+{
+	{
+		.name = "mutex",
+		.init_fn = bench_mutex_init,
+		.free_fn = bench_mutex_free,
+		.add_fn = bench_mutex_add,
+		.worker_fn = bench_mutex_worker_fn
+	},
+	{
+		.name = "pool",
+		.init_fn = bench_pool_init,
+		.free_fn = bench_pool_free,
+		.add_fn = bench_pool_add,
+		.worker_fn = bench_pool_worker_fn
+	},
+	{
+		.name = "batch",
+		.init_fn = bench_pool_init,
+		.free_fn = bench_pool_free,
+		.add_batch_fn = bench_pool_add_batch,
+		.worker_fn = bench_pool_worker_fn
+	}
+};
+
+
+private const bench_impl_t* bench_current_impl;
+
+
+private void
+bench_producer_fn(
+	void* data
+	)
+{
+	bench_state_t* state = data;
+
+	uint64_t count = state->task_count / state->producer_count;
+	thread_data_t task = { .fn = bench_task_fn, .data = state };
+
+	if(!bench_current_impl->add_batch_fn)
+	{
+		for(uint64_t i = 0; i < count; ++i)
+		{
+			bench_current_impl->add_fn(state, task);
+		}
+
+		return;
+	}
+
+	thread_data_t tasks[BENCH_BATCH_SIZE];
+
+	for(uint32_t i = 0; i < BENCH_BATCH_SIZE; ++i)
+	{
+		tasks[i] = task;
+	}
+
+	for(uint64_t i = 0; i < count; i += BENCH_BATCH_SIZE)
+	{
+		bench_current_impl->add_batch_fn(state, tasks,
+			MACRO_MIN(count - i, BENCH_BATCH_SIZE));
+	}
+}
+
+
+private uint64_t
+bench_run(
+	const bench_impl_t* impl,
+	uint64_t task_count,
+	uint32_t worker_count,
+	uint32_t producer_count
+	)
+{
+	bench_state_t state;
+	state.task_count = task_count - task_count % producer_count;
+	state.producer_count = producer_count;
+	atomic_init(&state.done, 0);
+
+	bench_current_impl = impl;
+	impl->init_fn(&state);
+
+	threads_t workers;
+	threads_init(&workers);
+	threads_add(&workers, (thread_data_t){ .fn = impl->worker_fn, .data = &state },
+		worker_count);
+
+	thread_t producers[producer_count];
+
+	uint64_t start = bench_get_time();
+
+	for(uint32_t i = 0; i < producer_count; ++i)
+	{
+		thread_init(&producers[i],
+			(thread_data_t){ .fn = bench_producer_fn, .data = &state });
+	}
+
+	for(uint32_t i = 0; i < producer_count; ++i)
+	{
+		thread_join(producers[i]);
+	}
+
+	while(atomic_load_explicit(&state.done, memory_order_relaxed) != state.task_count)
+	{
+		(void) sched_yield();
+	}
+
+	uint64_t time = bench_get_time() - start;
+
+	threads_cancel_all_sync(&workers);
+	threads_free(&workers);
+
+	impl->free_fn(&state);
+
+	return time;
+}
+
+
+int
+main(
+	int argc,
+	char** argv
+	)
+{
+	uint64_t task_count = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000;
+	uint32_t worker_count = argc > 2 ? strtoul(argv[2], NULL, 10) :
+		sysconf(_SC_NPROCESSORS_ONLN);
+	uint32_t producer_count = argc > 3 ? strtoul(argv[3], NULL, 10) : 1;
+
+	if(!task_count || !worker_count || !producer_count)
+	{
+		fprintf(stderr, "Usage: %s [tasks] [workers] [producers]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%" PRIu64 " tasks, %" PRIu32 " workers, %" PRIu32 " producers\n\n",
+		task_count, worker_count, producer_count);
+
+	printf("%-10s %10s %12s\n", "queue", "time ms", "Mtasks/s");
+
+	for(uint32_t i = 0; i < MACRO_ARRAY_LEN(bench_impls); ++i)
+	{
+		uint64_t best = UINT64_MAX;
+
+		for(uint32_t round = 0; round < BENCH_ROUNDS; ++round)
+		{
+			best = MACRO_MIN(best, bench_run(&bench_impls[i],
+				task_count, worker_count, producer_count));
+		}
+
+		printf("%-10s %10.2f %12.2f\n", bench_impls[i].name, best / 1e6,
+			task_count * 1e3 / best);
+	}
+
+	return 0;
+}